@@ -1,6 +1,50 @@
 #include "animation.h"
+#include "simd4.h"
 
-#include <algorithm>
+namespace
+{
+    // Initial group table size; a handful of groups are live at a time.
+    constexpr size_t kGroupSlots = 16;
+}
+
+AnimationSystem::AnimationSystem()
+{
+    for (auto & column : columns_) column.reserve(kReservedTweens);
+    tiles_.reserve(kReservedTweens);
+    props_.reserve(kReservedTweens);
+    group_ids_.reserve(kReservedTweens);
+    values_.reserve(kReservedTweens);
+    progress_.reserve(kReservedTweens);
+    groups_.resize(kGroupSlots);
+}
+
+AnimationSystem::GroupSlot & AnimationSystem::Slot(uint64_t id)
+{
+    for (;;)
+    {
+        GroupSlot & slot = groups_[id & (groups_.size() - 1)];
+        if (slot.id == id || !InUse(slot))
+        {
+            slot.id = id;
+            return slot;
+        }
+        GrowGroups();
+    }
+}
+
+void AnimationSystem::GrowGroups()
+{
+    // Ids distinct modulo n stay distinct modulo 2n, so live groups never collide.
+    std::vector<GroupSlot> old(groups_.size() * 2);
+    old.swap(groups_);
+    for (GroupSlot & slot : old)
+    {
+        if (InUse(slot))
+        {
+            groups_[slot.id & (groups_.size() - 1)] = std::move(slot);
+        }
+    }
+}
 
 uint64_t AnimationSystem::BeginGroup()
 {
@@ -13,54 +57,167 @@ void AnimationSystem::EndGroup()
     current_group_id_ = 0;
 }
 
-void AnimationSystem::Add(Animation anim)
+void AnimationSystem::Add(Tween tween)
 {
-    if (anim.group_id == 0)
+    if (tween.group_id == 0)
+    {
+        tween.group_id = current_group_id_;
+    }
+    float rate = 1.0f;
+    if (tween.group_id != 0)
+    {
+        GroupSlot & slot = Slot(tween.group_id);
+        ++slot.live;
+        rate = slot.time_scale;
+    }
+
+    const size_t i = count_++;
+    if (i >= values_.size())
     {
-        anim.group_id = current_group_id_;
+        const size_t n = simd4::Padded(count_);
+        for (auto & column : columns_) column.resize(n);
+        values_.resize(n);
+        progress_.resize(n);
     }
-    anims_.push_back(std::move(anim));
+    tiles_.resize(count_);
+    props_.resize(count_);
+    group_ids_.resize(count_);
+
+    // A zero duration finishes on the first step: t starts at 1 with unit rate.
+    const bool instant = tween.duration <= 0.0f;
+    const bool yoyo = tween.peak < 1.0f;
+    columns_[kT][i] = instant ? 1.0f : tween.t;
+    columns_[kRate][i] = rate;
+    columns_[kInvDuration][i] = instant ? 1.0f : 1.0f / tween.duration;
+    columns_[kFrom][i] = tween.from;
+    columns_[kDelta][i] = tween.to - tween.from;
+    columns_[kPeak][i] = tween.peak;
+    columns_[kInvPeak][i] = 1.0f / tween.peak;
+    columns_[kInvRest][i] = yoyo ? 1.0f / (1.0f - tween.peak) : 0.0f;
+    tiles_[i] = tween.tile;
+    props_[i] = tween.prop;
+    group_ids_[i] = tween.group_id;
+}
+
+void AnimationSystem::Update(float dt, TileStore & tiles)
+{
+    Step(dt * time_scale_, tiles, false);
 }
 
-void AnimationSystem::Update(float dt)
+void AnimationSystem::CompleteAll(TileStore & tiles)
 {
-    for (auto & a : anims_)
+    Step(0.0f, tiles, true);
+}
+
+void AnimationSystem::SetGroupTimeScale(uint64_t id, float scale)
+{
+    // A group without live tweens would never drain, so its slot would stay claimed.
+    if (!IsGroupActive(id))
     {
-        if (a.finished) continue;
-        a.t += dt;
-        const float p = (a.duration <= 0.0f) ? 1.0f : std::min(1.0f, a.t / a.duration);
-        if (a.apply) a.apply(p);
-        if (p >= 1.0f)
-        {
-            a.finished = true;
-            if (a.on_complete) a.on_complete();
-        }
+        return;
+    }
+    Slot(id).time_scale = scale;
+    for (size_t i = 0; i < count_; ++i)
+    {
+        if (group_ids_[i] == id) columns_[kRate][i] = scale;
+    }
+}
+
+void AnimationSystem::Evaluate(float dt, bool finish)
+{
+    using namespace simd4;
+    const F4 step = Splat(dt);
+    const F4 one = Splat(1.0f);
+
+    // Padding lanes past count_ hold finite leftovers; their results are unused.
+    for (size_t i = 0; i < count_; i += kLanes)
+    {
+        const F4 t = Load(&columns_[kT][i]) + step * Load(&columns_[kRate][i]);
+        Store(&columns_[kT][i], t);
+
+        const F4 p = finish ? one : Min(one, t * Load(&columns_[kInvDuration][i]));
+
+        // Out to 'to' until the peak, then (yoyo only) back to 'from'.
+        const F4 from = Load(&columns_[kFrom][i]);
+        const F4 delta = Load(&columns_[kDelta][i]);
+        const F4 peak = Load(&columns_[kPeak][i]);
+        const F4 out = from + delta * (p * Load(&columns_[kInvPeak][i]));
+        const F4 back = (from + delta) - delta * ((p - peak) * Load(&columns_[kInvRest][i]));
+        Store(&values_[i], Select((p <= peak) | (peak >= one), out, back));
+        Store(&progress_[i], p);
     }
+}
 
-    // Remove finished
-    anims_.erase(std::remove_if(anims_.begin(), anims_.end(),
-                                [](const Animation & a){ return a.finished; }),
-                 anims_.end());
+void AnimationSystem::MoveTween(size_t from, size_t to)
+{
+    for (auto & column : columns_) column[to] = column[from];
+    tiles_[to] = tiles_[from];
+    props_[to] = props_[from];
+    group_ids_[to] = group_ids_[from];
 }
 
-bool AnimationSystem::IsGroupActive(uint64_t id) const
+void AnimationSystem::Step(float dt, TileStore & tiles, bool finish)
 {
-    if (id == 0) return false;
-    for (const auto & a : anims_)
+    Evaluate(dt, finish);
+
+    // Write and compact in one pass; order is kept, so when two tweens drive
+    // the same property the later one still wins.
+    size_t kept = 0;
+    for (size_t i = 0; i < count_; ++i)
     {
-        if (!a.finished && a.group_id == id)
+        const uint32_t dense = tiles.Find(tiles_[i]);
+        if (dense != TileStore::kNoTile)
         {
-            return true;
+            tiles.Current(props_[i])[dense] = values_[i];
+        }
+
+        if (progress_[i] < 1.0f)
+        {
+            if (kept != i) MoveTween(i, kept);
+            ++kept;
+        }
+        else if (group_ids_[i] != 0)
+        {
+            GroupSlot & slot = groups_[group_ids_[i] & (groups_.size() - 1)];
+            if (--slot.live == 0)
+            {
+                slot.time_scale = 1.0f;
+                drained_.push_back(group_ids_[i]);
+            }
         }
     }
-    return false;
+    count_ = kept;
+    tiles_.resize(kept);
+    props_.resize(kept);
+    group_ids_.resize(kept);
+
+    // Callbacks last: they may add tweens or begin groups.
+    for (size_t i = 0; i < drained_.size(); ++i)
+    {
+        GroupSlot & slot = groups_[drained_[i] & (groups_.size() - 1)];
+        if (slot.id == drained_[i] && slot.live == 0 && slot.on_done)
+        {
+            std::function<void()> fn = std::move(slot.on_done);
+            slot.on_done = nullptr;
+            fn();
+        }
+    }
+    drained_.clear();
 }
 
-bool AnimationSystem::HasActive() const
+void AnimationSystem::OnGroupDone(uint64_t id, std::function<void()> fn)
 {
-    for (const auto & a : anims_)
+    if (!IsGroupActive(id))
     {
-        if (!a.finished) return true;
+        if (fn) fn();
+        return;
     }
-    return false;
+    Slot(id).on_done = std::move(fn);
+}
+
+bool AnimationSystem::IsGroupActive(uint64_t id) const
+{
+    if (id == 0) return false;
+    const GroupSlot & slot = groups_[id & (groups_.size() - 1)];
+    return slot.id == id && slot.live > 0;
 }
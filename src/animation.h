@@ -1,14 +1,18 @@
 #pragma once
+#include "tile_store.h"
+
+#include <array>
 #include <vector>
 #include <functional>
 #include <cstdint>
 #include <cmath>
 
-// Simple time-based animation system with groups.
-// Each animation linearly interpolates between 0..1 over 'duration' seconds
-// and calls 'apply(progress)'. When progress reaches 1, 'on_complete' (if any) is invoked.
-
-using EaseFn = std::function<float(float)>;
+// Time-based tweens with groups. A tween drives one float property of one
+// visual tile over 'duration' seconds. Tweens live in reused column arrays (no
+// per-tween allocation, no indirect calls); Update evaluates them four at a
+// time with simd4, then writes the values into the tiles in one pass.
+// Each group keeps a count of its live tweens, so group queries are O(1) and a
+// callback can run when a group drains.
 
 inline float EaseLinear(float t) { return t; }
 inline float EaseOutCubic(float t) { const float u = 1.0f - t; return 1.0f - u * u * u; }
@@ -21,34 +25,133 @@ inline float EaseOutBack(float t)
     return 1.0f + c3 * u * u * u + c1 * u * u;
 }
 
-struct Animation
+enum class Ease : uint8_t
 {
-    float t {0.0f};
+    Linear,
+    OutCubic,
+    OutBack
+};
+
+inline float ApplyEase(Ease ease, float t)
+{
+    switch (ease)
+    {
+        case Ease::Linear:   return EaseLinear(t);
+        case Ease::OutCubic: return EaseOutCubic(t);
+        case Ease::OutBack:  return EaseOutBack(t);
+    }
+    return t;
+}
+
+struct Tween
+{
+    TileHandle tile {};
+    TweenProp prop {TweenProp::X};
+    float from {0.0f};
+    float to {0.0f};
     float duration {0.0f};
-    std::function<void(float)> apply;   // receives eased progress in [0..1]
-    std::function<void()> on_complete;
+    // Not applied: progress is linear, as it was with the callback
+    // animations, so an OutBack yoyo cannot dip below 'from'.
+    Ease ease {Ease::Linear};
+    // Progress at which the value reaches 'to'; below 1 it then returns
+    // to 'from' by the end (a yoyo, e.g. a pulse).
+    float peak {1.0f};
     uint64_t group_id {0};
-    EaseFn ease {EaseLinear};
-    bool finished {false};
+    float t {0.0f};
 };
 
 class AnimationSystem
 {
 public:
+    AnimationSystem();
+
     uint64_t BeginGroup();
     uint64_t CurrentGroup() const { return current_group_id_; }
     void EndGroup();
 
-    void Add(Animation anim);
-    void Update(float dt);
+    // Group 0 joins the current group.
+    void Add(Tween tween);
+    // Advances every tween by dt times the global and group time scales and
+    // writes its value into its tile (skipped if the tile was removed);
+    // finished tweens are dropped in the same pass. Then runs the callbacks of
+    // the groups that drained, which may add tweens and groups.
+    void Update(float dt, TileStore & tiles);
+    // Finishes every tween now: final values written, all groups drained and
+    // their callbacks run, in one pass. Tweens added by those callbacks stay.
+    void CompleteAll(TileStore & tiles);
+
+    // Multiplies every dt (0 pauses, 4 is a 4x turbo).
+    void SetTimeScale(float scale) { time_scale_ = scale; }
+    float TimeScale() const { return time_scale_; }
+    // Extra scale for one group's tweens, on top of the global one. Applies to
+    // tweens already running; resets when the group drains. Ignored for a
+    // group with no live tweens.
+    void SetGroupTimeScale(uint64_t id, float scale);
+
+    // Runs fn once group 'id' has no live tweens left: at the end of the Update
+    // that finishes its last tween, or right away if it has none (or is 0).
+    // Replaces an earlier callback for the same group.
+    void OnGroupDone(uint64_t id, std::function<void()> fn);
 
     bool IsGroupActive(uint64_t id) const;
-    bool HasActive() const;
+    bool HasActive() const { return count_ > 0; }
 
 private:
-    std::vector<Animation> anims_;
+    struct GroupSlot
+    {
+        uint64_t id {0};
+        uint32_t live {0};
+        float time_scale {1.0f};
+        std::function<void()> on_done;
+    };
+
+    // Enough for the cascades of a large board; the array grows past it if needed
+    // and never shrinks.
+    static constexpr size_t kReservedTweens = 4096;
+
+    // Per-tween float columns. Add turns a Tween into the terms the SIMD pass
+    // needs: the time rate, 1/duration, start and delta, and the yoyo split.
+    enum Column : size_t
+    {
+        kT,
+        kRate,          // global scale excluded
+        kInvDuration,
+        kFrom,
+        kDelta,         // to - from
+        kPeak,
+        kInvPeak,
+        kInvRest,       // 1 / (1 - peak), or 0 without a yoyo
+        kColumns
+    };
+
+    // count_ tweens; every column is padded to whole simd4 vectors.
+    size_t count_ {0};
+    std::array<std::vector<float>, kColumns> columns_;
+    std::vector<TileHandle> tiles_;
+    std::vector<TweenProp> props_;
+    std::vector<uint64_t> group_ids_;
+    // Output of the SIMD pass: each tween's value and progress (1 = finished).
+    std::vector<float> values_;
+    std::vector<float> progress_;
+    // Groups with live tweens or a pending callback, at id & (size - 1); the
+    // table doubles when two of them would share a slot.
+    std::vector<GroupSlot> groups_;
+    // Groups drained during the current Update, scratch.
+    std::vector<uint64_t> drained_;
     uint64_t next_group_id_ {1};
     uint64_t current_group_id_ {0};
+    float time_scale_ {1.0f};
+
+    static bool InUse(const GroupSlot & slot) { return slot.live > 0 || slot.on_done || slot.time_scale != 1.0f; }
+    // The slot of group 'id', claimed for it (growing the table if needed).
+    GroupSlot & Slot(uint64_t id);
+    void GrowGroups();
+    // Update, or with 'finish' every tween jumps to its end.
+    void Step(float dt, TileStore & tiles, bool finish);
+    // Writes values_ and progress_ for every tween.
+    void Evaluate(float dt, bool finish);
+    // Copies tween 'from' over tween 'to' (compaction).
+    void MoveTween(size_t from, size_t to);
 };
 
 inline float Lerp(const float a, const float b, const float t)
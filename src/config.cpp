@@ -1,6 +1,8 @@
 #include "config.h"
+#include "board.h"
 
 #include <yaml-cpp/yaml.h>
+#include <algorithm>
 #include <iostream>
 
 bool Config::Load(const std::string & path)
@@ -12,6 +14,41 @@ bool Config::Load(const std::string & path)
         {
             hint_delay_seconds = node["hint_delay_seconds"].as<float>();
         }
+        if (node["tick_rate_hz"])
+        {
+            tick_rate_hz = std::clamp(node["tick_rate_hz"].as<int>(), 10, 1000);
+        }
+        if (node["max_catch_up_ticks"])
+        {
+            max_catch_up_ticks = std::clamp(node["max_catch_up_ticks"].as<int>(), 1, 100);
+        }
+        auto seconds = [&](const char * key, float & out) {
+            if (node[key]) out = std::clamp(node[key].as<float>(), 0.0f, 5.0f);
+        };
+        seconds("swap_seconds", swap_seconds);
+        seconds("fade_seconds", fade_seconds);
+        seconds("drop_seconds", drop_seconds);
+        seconds("bump_seconds", bump_seconds);
+        if (node["animation_speed"])
+        {
+            animation_speed = std::clamp(node["animation_speed"].as<float>(), 0.01f, 1000.0f);
+        }
+        if (node["instant_animations"])
+        {
+            instant_animations = node["instant_animations"].as<bool>();
+        }
+        if (node["board_width"])
+        {
+            board_width = std::clamp(node["board_width"].as<int>(), 3, kMaxBoardSide);
+        }
+        if (node["board_height"])
+        {
+            board_height = std::clamp(node["board_height"].as<int>(), 3, kMaxBoardSide);
+        }
+        if (node["replay_path"])
+        {
+            replay_path = node["replay_path"].as<std::string>();
+        }
         return true;
     }
     catch (const std::exception & e)
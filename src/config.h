@@ -4,6 +4,23 @@
 struct Config
 {
     float hint_delay_seconds {5.0f};
+    // Fixed simulation rate; rendering interpolates between ticks.
+    int tick_rate_hz {120};
+    // Ticks one frame may run to catch up after a stall; time beyond that is dropped.
+    int max_catch_up_ticks {8};
+    // Tween durations in seconds.
+    float swap_seconds {0.15f};
+    float fade_seconds {0.14f};
+    float drop_seconds {0.20f};
+    float bump_seconds {0.10f};
+    // Global animation time scale (2 = twice as fast); instant_animations
+    // finishes every tween on the tick it starts, for automated playtests.
+    float animation_speed {1.0f};
+    bool instant_animations {false};
+    int board_width {6};
+    int board_height {6};
+    // Replay of the session is written here on exit; empty disables recording.
+    std::string replay_path;
 
     bool Load(const std::string & path);
 };
@@ -0,0 +1,319 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+// Bit sets addressed by linear cell index (y * width + x).
+// Used both as per-color bitplanes inside boards and as the match mask
+// handed to the collapse step and the visuals.
+//
+// BitMask<N> has a compile-time size and lives entirely on the stack;
+// BitMask<kDynamicBits> is sized at runtime and backed by a vector.
+// Both share the same interface.
+//
+// Invariant: bits at positions >= Size() are always zero, so shifts and
+// popcounts never pick up garbage past the last cell.
+
+inline constexpr int kDynamicBits = 0;
+
+// Word w of (a >> n) over an array of 'words' words: result bit i = a bit (i + n).
+constexpr uint64_t ShrWord(const uint64_t * a, int words, int w, int n)
+{
+    const int src = w + (n >> 6);
+    const int bs = n & 63;
+    if (src >= words) return 0;
+    uint64_t v = a[src] >> bs;
+    if (bs != 0 && src + 1 < words)
+    {
+        v |= a[src + 1] << (64 - bs);
+    }
+    return v;
+}
+
+// Word w of (a << n): result bit i = a bit (i - n). The caller trims the tail.
+constexpr uint64_t ShlWord(const uint64_t * a, int words, int w, int n)
+{
+    (void)words;
+    const int src = w - (n >> 6);
+    const int bs = n & 63;
+    if (src < 0) return 0;
+    uint64_t v = a[src] << bs;
+    if (bs != 0 && src - 1 >= 0)
+    {
+        v |= a[src - 1] >> (64 - bs);
+    }
+    return v;
+}
+
+constexpr uint64_t TailMask(int bits)
+{
+    return (bits & 63) ? ((uint64_t{1} << (bits & 63)) - 1) : ~uint64_t{0};
+}
+
+template <int Bits>
+class BitMask
+{
+public:
+    static constexpr int kBits = Bits;
+    static constexpr int kWords = (Bits + 63) / 64;
+
+    constexpr BitMask() = default;
+
+    constexpr int Size() const { return kBits; }
+    constexpr int WordCount() const { return kWords; }
+
+    // Fixed masks cannot change size; this only clears, so generic code can
+    // treat fixed and dynamic masks alike.
+    constexpr void Resize(int bits) { (void)bits; Clear(); }
+
+    constexpr bool Test(int i) const
+    {
+        return (words_[i >> 6] >> (i & 63)) & 1u;
+    }
+
+    constexpr void Set(int i)
+    {
+        words_[i >> 6] |= (uint64_t{1} << (i & 63));
+    }
+
+    constexpr void Reset(int i)
+    {
+        words_[i >> 6] &= ~(uint64_t{1} << (i & 63));
+    }
+
+    constexpr void Clear()
+    {
+        words_.fill(0);
+    }
+
+    constexpr bool Any() const
+    {
+        for (int w = 0; w < kWords; ++w)
+        {
+            if (words_[w]) return true;
+        }
+        return false;
+    }
+
+    constexpr int Count() const
+    {
+        int n = 0;
+        for (int w = 0; w < kWords; ++w)
+        {
+            n += std::popcount(words_[w]);
+        }
+        return n;
+    }
+
+    constexpr uint64_t Word(int w) const { return words_[w]; }
+    constexpr uint64_t * Data() { return words_.data(); }
+    constexpr const uint64_t * Data() const { return words_.data(); }
+
+    constexpr BitMask & operator&=(const BitMask & o)
+    {
+        for (int w = 0; w < kWords; ++w) words_[w] &= o.words_[w];
+        return *this;
+    }
+
+    constexpr BitMask & operator|=(const BitMask & o)
+    {
+        for (int w = 0; w < kWords; ++w) words_[w] |= o.words_[w];
+        return *this;
+    }
+
+    friend constexpr BitMask operator&(BitMask a, const BitMask & b) { return a &= b; }
+    friend constexpr BitMask operator|(BitMask a, const BitMask & b) { return a |= b; }
+
+    // this & ~o, without materializing the complement (keeps the tail clear).
+    constexpr BitMask AndNot(const BitMask & o) const
+    {
+        BitMask r;
+        for (int w = 0; w < kWords; ++w) r.words_[w] = words_[w] & ~o.words_[w];
+        return r;
+    }
+
+    // Result bit i = this bit (i + n). Bits shifted in from the top are zero.
+    constexpr BitMask Shr(int n) const
+    {
+        BitMask r;
+        for (int w = 0; w < kWords; ++w) r.words_[w] = ShrWord(words_.data(), kWords, w, n);
+        return r;
+    }
+
+    // Result bit i = this bit (i - n). Bits pushed past kBits are dropped.
+    constexpr BitMask Shl(int n) const
+    {
+        BitMask r;
+        for (int w = 0; w < kWords; ++w) r.words_[w] = ShlWord(words_.data(), kWords, w, n);
+        r.words_[kWords - 1] &= TailMask(kBits);
+        return r;
+    }
+
+    // Calls fn(index) for every set bit in ascending order.
+    template <typename Fn>
+    void ForEachSet(Fn && fn) const
+    {
+        for (int w = 0; w < kWords; ++w)
+        {
+            uint64_t bits = words_[w];
+            while (bits)
+            {
+                fn(w * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // Mask with every cell whose column lies in [x0, x1] set.
+    static constexpr BitMask Columns(int width, int height, int x0, int x1)
+    {
+        (void)height;
+        BitMask r;
+        for (int i = 0; i < kBits; ++i)
+        {
+            const int x = i % width;
+            if (x >= x0 && x <= x1) r.Set(i);
+        }
+        return r;
+    }
+
+    friend constexpr bool operator==(const BitMask & a, const BitMask & b) = default;
+
+private:
+    std::array<uint64_t, kWords> words_ {};
+};
+
+template <>
+class BitMask<kDynamicBits>
+{
+public:
+    static constexpr int kBits = kDynamicBits;
+    static constexpr int kWords = 0;
+
+    BitMask() = default;
+    explicit BitMask(int bits) { Resize(bits); }
+
+    int Size() const { return bits_; }
+    int WordCount() const { return static_cast<int>(words_.size()); }
+
+    // Sets the size and clears all bits. Does not reallocate when the size is unchanged.
+    void Resize(int bits)
+    {
+        bits_ = bits;
+        words_.assign((bits + 63) / 64, 0);
+    }
+
+    bool Test(int i) const
+    {
+        return (words_[i >> 6] >> (i & 63)) & 1u;
+    }
+
+    void Set(int i)
+    {
+        words_[i >> 6] |= (uint64_t{1} << (i & 63));
+    }
+
+    void Reset(int i)
+    {
+        words_[i >> 6] &= ~(uint64_t{1} << (i & 63));
+    }
+
+    void Clear()
+    {
+        std::fill(words_.begin(), words_.end(), 0);
+    }
+
+    bool Any() const
+    {
+        for (uint64_t w : words_)
+        {
+            if (w) return true;
+        }
+        return false;
+    }
+
+    int Count() const
+    {
+        int n = 0;
+        for (uint64_t w : words_)
+        {
+            n += std::popcount(w);
+        }
+        return n;
+    }
+
+    uint64_t Word(int w) const { return words_[w]; }
+    uint64_t * Data() { return words_.data(); }
+    const uint64_t * Data() const { return words_.data(); }
+
+    BitMask & operator&=(const BitMask & o)
+    {
+        for (size_t w = 0; w < words_.size(); ++w) words_[w] &= o.words_[w];
+        return *this;
+    }
+
+    BitMask & operator|=(const BitMask & o)
+    {
+        for (size_t w = 0; w < words_.size(); ++w) words_[w] |= o.words_[w];
+        return *this;
+    }
+
+    friend BitMask operator&(BitMask a, const BitMask & b) { return a &= b; }
+    friend BitMask operator|(BitMask a, const BitMask & b) { return a |= b; }
+
+    BitMask AndNot(const BitMask & o) const
+    {
+        BitMask r(bits_);
+        for (size_t w = 0; w < words_.size(); ++w) r.words_[w] = words_[w] & ~o.words_[w];
+        return r;
+    }
+
+    BitMask Shr(int n) const
+    {
+        BitMask r(bits_);
+        const int words = WordCount();
+        for (int w = 0; w < words; ++w) r.words_[w] = ShrWord(words_.data(), words, w, n);
+        return r;
+    }
+
+    BitMask Shl(int n) const
+    {
+        BitMask r(bits_);
+        const int words = WordCount();
+        for (int w = 0; w < words; ++w) r.words_[w] = ShlWord(words_.data(), words, w, n);
+        if (words > 0) r.words_[words - 1] &= TailMask(bits_);
+        return r;
+    }
+
+    template <typename Fn>
+    void ForEachSet(Fn && fn) const
+    {
+        for (size_t w = 0; w < words_.size(); ++w)
+        {
+            uint64_t bits = words_[w];
+            while (bits)
+            {
+                fn(static_cast<int>(w) * 64 + std::countr_zero(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    static BitMask Columns(int width, int height, int x0, int x1)
+    {
+        BitMask r(width * height);
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = x0; x <= x1; ++x) r.Set(y * width + x);
+        }
+        return r;
+    }
+
+    friend bool operator==(const BitMask & a, const BitMask & b) = default;
+
+private:
+    std::vector<uint64_t> words_;
+    int bits_ {0};
+};
@@ -0,0 +1,1305 @@
+#include "board.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <vector>
+
+namespace
+{
+    constexpr uint8_t kUnsetColor = 0xFF;
+    constexpr uint32_t kAllColors = (1u << static_cast<int>(CellType::Count)) - 1;
+
+    // Shape classification tables. A cell's horizontal (vertical) window holds
+    // the same-color run cells from x-4 to x+4 (y-4 to y+4), the cell itself
+    // being bit 4. kRunLength gives the length of the run through bit 4,
+    // capped at 5; kShapeSpecial maps the horizontal and vertical lengths to
+    // the special the cell would become.
+    constexpr std::array<uint8_t, 512> kRunLength = [] {
+        std::array<uint8_t, 512> t {};
+        for (int w = 0; w < 512; ++w)
+        {
+            if (!(w & 16)) continue;
+            int n = 1;
+            for (int k = 5; k < 9 && ((w >> k) & 1); ++k) ++n;
+            for (int k = 3; k >= 0 && ((w >> k) & 1); --k) ++n;
+            t[w] = static_cast<uint8_t>(std::min(n, 5));
+        }
+        return t;
+    }();
+
+    constexpr std::array<std::array<Special, 6>, 6> kShapeSpecial = [] {
+        std::array<std::array<Special, 6>, 6> t {};
+        for (int h = 0; h < 6; ++h)
+        {
+            for (int v = 0; v < 6; ++v)
+            {
+                // Lengths below 3 are cells of a run in the other direction only.
+                const int rh = h >= 3 ? h : 0;
+                const int rv = v >= 3 ? v : 0;
+                Special s = Special::None;
+                if (rh >= 5 || rv >= 5)      s = Special::ColorBomb;
+                else if (rh && rv)           s = Special::Wrapped;
+                else if (rh == 4)            s = Special::StripedV;
+                else if (rv == 4)            s = Special::StripedH;
+                t[h][v] = s;
+            }
+        }
+        return t;
+    }();
+
+    // Cheap test on the union of all runs: true if some run has 4+ cells or a
+    // horizontal and a vertical run overlap. Runs of different colors side by
+    // side can pass it too; ClassifyShapes sorts those out. Most steps are
+    // lone threes and stop here.
+    template <int Words, typename Scratch>
+    bool MayFormSpecial(const uint64_t * runs, const uint64_t * origins_h, int words_rt, int width, Scratch & s)
+    {
+        const int words = Words ? Words : words_rt;
+
+        uint64_t any = 0;
+        for (int w = 0; w < words; ++w)
+        {
+            s.h[w] = runs[w] & ShrWord(runs, words, w, 1) & ShrWord(runs, words, w, 2) & origins_h[w];
+            s.v[w] = runs[w] & ShrWord(runs, words, w, width) & ShrWord(runs, words, w, 2 * width);
+            any |= s.v[w] & ShrWord(runs, words, w, 3 * width);
+        }
+        for (int w = 0; w < words; ++w)
+        {
+            // Two overlapping horizontal triples make a run of four.
+            any |= s.h[w] & ShrWord(&s.h[0], words, w, 1);
+            const uint64_t hm = s.h[w] | ShlWord(&s.h[0], words, w, 1) | ShlWord(&s.h[0], words, w, 2);
+            const uint64_t vm = s.v[w] | ShlWord(&s.v[0], words, w, width) | ShlWord(&s.v[0], words, w, 2 * width);
+            any |= hm & vm;
+        }
+        return any != 0;
+    }
+
+    // Which special a group keeps when several of its cells qualify.
+    constexpr std::array<int, static_cast<int>(Special::Count)> kSpecialRank = {0, 1, 1, 2, 3};
+
+    // Scratch word buffer for the match kernel: a stack array for fixed boards,
+    // a per-thread vector for dynamic ones (grown once, reused afterwards).
+    template <int Words>
+    struct KernelScratch
+    {
+        std::array<uint64_t, Words> h, v, hm, vm;
+
+        explicit KernelScratch(int words) { (void)words; }
+    };
+
+    template <>
+    struct KernelScratch<0>
+    {
+        uint64_t * h;
+        uint64_t * v;
+        uint64_t * hm;
+        uint64_t * vm;
+
+        explicit KernelScratch(int words)
+        {
+            thread_local std::vector<uint64_t> storage;
+            if (storage.size() < static_cast<size_t>(words) * 4)
+            {
+                storage.resize(static_cast<size_t>(words) * 4);
+            }
+            h = storage.data();
+            v = h + words;
+            hm = v + words;
+            vm = hm + words;
+        }
+    };
+
+    // Bit-parallel run detection over one color plane:
+    //  - a triple starts at i when bits i, i+1, i+2 (or i, i+W, i+2W) are all set;
+    //  - a run is the union of its triples;
+    //  - each maximal run contributes exactly one start bit, which gives the group count.
+    // 'Words' is the compile-time word count (0 = runtime 'words'), so fixed
+    // boards get fully unrolled loops with constant shifts.
+    template <int Words, typename Scratch>
+    int DetectRuns(const uint64_t * plane, const uint64_t * origins_h, const uint64_t * not_first_col,
+                   int words_rt, int width, Scratch & s, uint64_t * out)
+    {
+        const int words = Words ? Words : words_rt;
+
+        uint64_t any = 0;
+        for (int w = 0; w < words; ++w)
+        {
+            s.h[w] = plane[w] & ShrWord(plane, words, w, 1) & ShrWord(plane, words, w, 2) & origins_h[w];
+            s.v[w] = plane[w] & ShrWord(plane, words, w, width) & ShrWord(plane, words, w, 2 * width);
+            any |= s.h[w] | s.v[w];
+        }
+        if (!any)
+        {
+            return 0;
+        }
+
+        for (int w = 0; w < words; ++w)
+        {
+            // Triples never extend past the last cell, so no tail trimming is needed here.
+            s.hm[w] = s.h[w] | ShlWord(&s.h[0], words, w, 1) | ShlWord(&s.h[0], words, w, 2);
+            s.vm[w] = s.v[w] | ShlWord(&s.v[0], words, w, width) | ShlWord(&s.v[0], words, w, 2 * width);
+        }
+
+        int groups = 0;
+        for (int w = 0; w < words; ++w)
+        {
+            const uint64_t h_starts = s.hm[w] & ~(ShlWord(&s.hm[0], words, w, 1) & not_first_col[w]);
+            const uint64_t v_starts = s.vm[w] & ~ShlWord(&s.vm[0], words, w, width);
+            groups += std::popcount(h_starts) + std::popcount(v_starts);
+            out[w] |= s.hm[w] | s.vm[w];
+        }
+        return groups;
+    }
+}
+
+template <int W, int H>
+BasicBoard<W, H>::BasicBoard()
+{
+    InitStorage();
+}
+
+template <int W, int H>
+BasicBoard<W, H>::BasicBoard(int width, int height)
+{
+    if constexpr (kDynamic)
+    {
+        assert(width >= 3 && height >= 3 && width <= kMaxBoardSide && height <= kMaxBoardSide);
+        this->width_ = width;
+        this->height_ = height;
+        this->run_origins_h_ = Mask::Columns(width, height, 0, width - 3);
+        this->not_first_column_ = Mask::Columns(width, height, 1, width - 1);
+    }
+    else
+    {
+        assert(width == W && height == H);
+        (void)width;
+        (void)height;
+    }
+    InitStorage();
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::InitStorage()
+{
+    if constexpr (kDynamic)
+    {
+        cells_.assign(Cells(), CellType::Red);
+    }
+    else
+    {
+        cells_.fill(CellType::Red);
+    }
+
+    if constexpr (kDynamic)
+    {
+        specials_.assign(Cells(), Special::None);
+    }
+    else
+    {
+        specials_.fill(Special::None);
+    }
+
+    for (auto & plane : planes_)
+    {
+        plane.Resize(Cells());
+    }
+    fired_.Resize(Cells());
+    hash_ = 0;
+    for (int i = 0; i < Cells(); ++i)
+    {
+        planes_[static_cast<int>(CellType::Red)].Set(i);
+        hash_ ^= ZobristKey(i, CellType::Red);
+    }
+
+    dirty_rows_.Resize(Height());
+    dirty_cols_.Resize(Width());
+    MarkAllDirty();
+
+    swap_right_.Resize(Cells());
+    swap_down_.Resize(Cells());
+    move_count_ = 0;
+    if constexpr (kDynamic)
+    {
+        column_low_.assign(Width(), -1);
+        column_gone_.assign(static_cast<size_t>(Width()) * ((Height() + 63) / 64), 0);
+        spawn_draws_.assign(Width(), 0);
+    }
+    RefreshMoves(0, 0, Width() - 1, Height() - 1);
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::GenerateInitial(uint32_t seed, int min_moves)
+{
+    SeedRng(seed);
+
+    thread_local std::vector<uint8_t> colors;
+    thread_local std::vector<int> boxes;
+    colors.assign(Cells(), kUnsetColor);
+
+    // Plant move patterns in distinct boxes picked by a partial Fisher-Yates.
+    const int box_count = MaxPlantedMoves();
+    const int plant = std::clamp(min_moves, 0, box_count);
+    boxes.resize(box_count);
+    for (int i = 0; i < box_count; ++i) boxes[i] = i;
+    int planted = 0;
+    for (int i = 0; i < plant; ++i)
+    {
+        const int j = i + static_cast<int>(UniformBelow(rng_, static_cast<uint32_t>(box_count - i)));
+        std::swap(boxes[i], boxes[j]);
+        planted += PlantMove(colors, boxes[i]) ? 1 : 0;
+    }
+
+    // Fill the rest. At most two colors are excluded per direction, so with
+    // six colors there are always at least two to choose from.
+    for (int y = 0; y < Height(); ++y)
+    {
+        for (int x = 0; x < Width(); ++x)
+        {
+            uint8_t & c = colors[Index({x, y})];
+            if (c == kUnsetColor)
+            {
+                c = PickColor(kAllColors & ~ExcludedColors(colors, x, y));
+            }
+        }
+    }
+
+    for (int i = 0; i < Cells(); ++i)
+    {
+        SetCell(i, static_cast<CellType>(colors[i]));
+    }
+    MarkAllDirty();
+    RefreshMoves(0, 0, Width() - 1, Height() - 1);
+
+#ifndef NDEBUG
+    {
+        Mask mask;
+        int groups = 0;
+        int cells = 0;
+        assert(!FindMatches(mask, groups, cells));
+        assert(move_count_ >= planted);
+    }
+#endif
+    (void)planted;
+}
+
+// Colors that would complete a horizontal or vertical run of three at (x, y),
+// given the cells assigned so far (on either side of it).
+template <int W, int H>
+uint32_t BasicBoard<W, H>::ExcludedColors(const std::vector<uint8_t> & colors, int x, int y) const
+{
+    uint32_t excluded = 0;
+    auto pair = [&](int xa, int ya, int xb, int yb) {
+        if (xa < 0 || ya < 0 || xb >= Width() || yb >= Height()) return;
+        const uint8_t a = colors[Index({xa, ya})];
+        if (a != kUnsetColor && a == colors[Index({xb, yb})]) excluded |= 1u << a;
+    };
+    pair(x - 2, y, x - 1, y);
+    pair(x - 1, y, x + 1, y);
+    pair(x + 1, y, x + 2, y);
+    pair(x, y - 2, x, y - 1);
+    pair(x, y - 1, x, y + 1);
+    pair(x, y + 1, x, y + 2);
+    return excluded;
+}
+
+// Box b covers columns 3bx..3bx+2 and rows 2by..2by+1. Two cells of one color
+// sit side by side in one row and a third sits diagonally below/above the
+// remaining column; swapping it vertically completes the triple:
+//
+//   A A .     . A A     . . A     A . .
+//   . . A     A . .     A A .     . A A
+//
+// The color is chosen among those that complete no run with cells planted earlier.
+template <int W, int H>
+bool BasicBoard<W, H>::PlantMove(std::vector<uint8_t> & colors, int box)
+{
+    const int boxes_x = Width() / 3;
+    const int bx = (box % boxes_x) * 3;
+    const int by = (box / boxes_x) * 2;
+    const int variant = static_cast<int>(UniformBelow(rng_, 4));
+
+    const int pair_row = by + (variant & 1);
+    const int single_row = by + 1 - (variant & 1);
+    const int pair_x = bx + ((variant & 2) ? 1 : 0);
+    const int single_x = (variant & 2) ? bx : bx + 2;
+    const IVec2 cells[3] = {{pair_x, pair_row}, {pair_x + 1, pair_row}, {single_x, single_row}};
+
+    uint32_t allowed = 0;
+    for (int c = 0; c < kColors; ++c)
+    {
+        for (const IVec2 & p : cells) colors[Index(p)] = static_cast<uint8_t>(c);
+        bool ok = true;
+        for (const IVec2 & p : cells) ok = ok && !(ExcludedColors(colors, p.x, p.y) & (1u << c));
+        if (ok) allowed |= 1u << c;
+    }
+
+    const uint8_t color = allowed ? PickColor(allowed) : kUnsetColor;
+    for (const IVec2 & p : cells) colors[Index(p)] = color;
+    return allowed != 0;
+}
+
+// Uniform pick among the set bits of 'allowed' (must be non-zero).
+template <int W, int H>
+uint8_t BasicBoard<W, H>::PickColor(uint32_t allowed)
+{
+    assert(allowed != 0);
+    int k = static_cast<int>(UniformBelow(rng_, static_cast<uint32_t>(std::popcount(allowed))));
+    while (k-- > 0) allowed &= allowed - 1;
+    return static_cast<uint8_t>(std::countr_zero(allowed));
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::LoadCells(const CellType * cells, const Special * specials)
+{
+    for (int i = 0; i < Cells(); ++i)
+    {
+        SetCell(i, cells[i], specials ? specials[i] : Special::None);
+    }
+    MarkAllDirty();
+    RefreshMoves(0, 0, Width() - 1, Height() - 1);
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::SeedRng(uint64_t seed)
+{
+    rng_.Seed(seed);
+    std::fill(spawn_draws_.begin(), spawn_draws_.end(), 0);
+}
+
+// Little-endian u64 words: key, stream 0 position, then one position per column.
+template <int W, int H>
+std::string BasicBoard<W, H>::RngState() const
+{
+    std::string out;
+    out.reserve(8 * (2 + Width()));
+    auto put = [&](uint64_t v) {
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>(v >> (8 * i)));
+    };
+    put(rng_.Key());
+    put(rng_.Position());
+    for (uint64_t n : spawn_draws_) put(n);
+    return out;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::SetRngState(const std::string & state)
+{
+    if (state.size() != 8 * static_cast<size_t>(2 + Width()))
+    {
+        return false;
+    }
+    auto get = [&](int word) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(state[8 * word + i])) << (8 * i);
+        return v;
+    };
+    rng_.Seed(get(0));
+    rng_.SetPosition(get(1));
+    for (int x = 0; x < Width(); ++x) spawn_draws_[x] = get(2 + x);
+    return true;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::GetRngWords(uint64_t * out) const
+{
+    out[0] = rng_.Key();
+    out[1] = rng_.Position();
+    std::copy(spawn_draws_.begin(), spawn_draws_.end(), out + 2);
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::SetRngWords(const uint64_t * words)
+{
+    rng_.Seed(words[0]);
+    rng_.SetPosition(words[1]);
+    std::copy(words + 2, words + 2 + Width(), spawn_draws_.begin());
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::InBounds(const IVec2 & p) const
+{
+    return p.x >= 0 && p.y >= 0 && p.x < Width() && p.y < Height();
+}
+
+template <int W, int H>
+CellType BasicBoard<W, H>::Get(const IVec2 & p) const
+{
+    return cells_[Index(p)];
+}
+
+template <int W, int H>
+Special BasicBoard<W, H>::GetSpecial(const IVec2 & p) const
+{
+    return specials_[Index(p)];
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::Set(const IVec2 & p, CellType c, Special s)
+{
+    SetCell(Index(p), c, s);
+    MarkDirty(p);
+    RefreshMoves(p.x - 3, p.y - 3, p.x + 2, p.y + 2);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::AreAdjacent(const IVec2 & a, const IVec2 & b) const
+{
+    const int dx = std::abs(a.x - b.x);
+    const int dy = std::abs(a.y - b.y);
+    return (dx + dy) == 1;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::Swap(const IVec2 & a, const IVec2 & b)
+{
+    if (!InBounds(a) || !InBounds(b))
+    {
+        return;
+    }
+    const int ia = Index(a);
+    const int ib = Index(b);
+    const CellType ca = cells_[ia];
+    const CellType cb = cells_[ib];
+    const Special sa = specials_[ia];
+    const Special sb = specials_[ib];
+    SetCell(ia, cb, sb);
+    SetCell(ib, ca, sa);
+    MarkDirty(a);
+    MarkDirty(b);
+    RefreshMoves(std::min(a.x, b.x) - 3, std::min(a.y, b.y) - 3,
+                 std::max(a.x, b.x) + 2, std::max(a.y, b.y) + 2);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::FindMatches(Mask & out_mask, int & out_groups, int & out_cells) const
+{
+    out_mask.Resize(Cells());
+    out_groups = 0;
+    out_cells = 0;
+    return FindMatchesMask(out_mask, out_groups, out_cells);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::FindMatchesDirty(Mask & out_mask, int & out_groups, int & out_cells)
+{
+    out_mask.Resize(Cells());
+    out_groups = 0;
+    out_cells = 0;
+
+    int row_lo = Height();
+    int row_hi = -1;
+    dirty_rows_.ForEachSet([&](int y) {
+        out_groups += ScanLine(Index({0, y}), 1, Width(), out_mask);
+        row_lo = std::min(row_lo, y);
+        row_hi = std::max(row_hi, y);
+    });
+
+    if (row_hi >= 0)
+    {
+        // A new vertical run must contain a changed cell, and since the board
+        // was clean before those changes it can extend at most two unchanged
+        // cells past the changed span.
+        const int y0 = std::max(0, row_lo - 2);
+        const int y1 = std::min(Height() - 1, row_hi + 2);
+        dirty_cols_.ForEachSet([&](int x) {
+            out_groups += ScanLine(Index({x, y0}), Width(), y1 - y0 + 1, out_mask);
+        });
+    }
+
+    out_cells = out_mask.Count();
+
+    if (out_cells == 0)
+    {
+        dirty_rows_.Clear();
+        dirty_cols_.Clear();
+        return false;
+    }
+    return true;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::MarkAllDirty()
+{
+    for (int y = 0; y < Height(); ++y) dirty_rows_.Set(y);
+    for (int x = 0; x < Width(); ++x) dirty_cols_.Set(x);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::ResolveMatches(Mask & out_mask, int & out_groups, int & out_cells,
+                                      std::vector<Transform> & out_created,
+                                      const IVec2 & swap_a, const IVec2 & swap_b)
+{
+    const bool matched = FindMatchesDirty(out_mask, out_groups, out_cells);
+    const size_t first_created = out_created.size();
+    if (matched)
+    {
+        constexpr int kWords = Mask::kWords;
+        const int words = out_mask.WordCount();
+        KernelScratch<kWords> scratch(words);
+        if (MayFormSpecial<kWords>(out_mask.Data(), this->RunOriginsH().Data(), words, Width(), scratch))
+        {
+            ClassifyShapes(out_mask, swap_a, swap_b, out_created);
+        }
+    }
+
+    fired_.Clear();
+
+    // A color bomb swapped with a candy clears that candy's color; two bombs
+    // clear everything (within kSpecialReach of the bombs). Either way the bombs are spent, not fired.
+    bool bomb_swap = false;
+    if (InBounds(swap_a) && InBounds(swap_b))
+    {
+        const int ia = Index(swap_a);
+        const int ib = Index(swap_b);
+        const bool bomb_a = cells_[ia] == CellType::ColorBomb;
+        const bool bomb_b = cells_[ib] == CellType::ColorBomb;
+        if (bomb_a && bomb_b)
+        {
+            MarkArea(out_mask, swap_a.x, swap_a.y, true, true);
+            MarkArea(out_mask, swap_b.x, swap_b.y, true, true);
+        }
+        else if (bomb_a || bomb_b)
+        {
+            const IVec2 & bomb = bomb_a ? swap_a : swap_b;
+            MarkArea(out_mask, bomb.x, bomb.y, true, true, &planes_[static_cast<int>(cells_[bomb_a ? ib : ia])]);
+        }
+        bomb_swap = bomb_a || bomb_b;
+        if (bomb_swap)
+        {
+            out_mask.Set(ia);
+            out_mask.Set(ib);
+            if (bomb_a) fired_.Set(ia);
+            if (bomb_b) fired_.Set(ib);
+        }
+    }
+
+    if (!matched && !bomb_swap)
+    {
+        return false;
+    }
+
+    FireSpecials(out_mask, fired_);
+
+    // New specials take the place of the candy they were made from, whatever
+    // else cleared that cell in the same step.
+    for (size_t k = first_created; k < out_created.size(); ++k)
+    {
+        const Transform & t = out_created[k];
+        const int idx = Index(t.at);
+        out_mask.Reset(idx);
+        SetCell(idx, t.type, t.special);
+        MarkDirty(t.at);
+        RefreshMoves(t.at.x - 3, t.at.y - 3, t.at.x + 2, t.at.y + 2);
+    }
+
+    out_groups = std::max(out_groups, 1);
+    out_cells = out_mask.Count();
+    return true;
+}
+
+// Splits the run cells into same-color 4-connected groups and picks, per
+// group, the cell with the best special according to the shape tables
+// (ties: a swapped cell, then the first reached). Groups of plain threes
+// create nothing, and groups past the first kMaxCreatedPerStep specials are
+// plain matches.
+template <int W, int H>
+void BasicBoard<W, H>::ClassifyShapes(const Mask & runs, const IVec2 & swap_a, const IVec2 & swap_b,
+                                      std::vector<Transform> & out_created) const
+{
+    thread_local Mask visited;
+    thread_local std::vector<int> stack;
+    visited.Resize(Cells());
+
+    auto in_run = [&](int x, int y, CellType c) {
+        if (x < 0 || y < 0 || x >= Width() || y >= Height()) return false;
+        const int j = Index({x, y});
+        return runs.Test(j) && cells_[j] == c;
+    };
+    auto shape = [&](int x, int y, CellType c) {
+        const Mask & plane = planes_[static_cast<int>(c)];
+        const uint32_t h = RowWindow(runs, x, y, 4) & RowWindow(plane, x, y, 4);
+        const uint32_t v = ColumnWindow(runs, x, y, 4) & ColumnWindow(plane, x, y, 4);
+        return kShapeSpecial[kRunLength[h]][kRunLength[v]];
+    };
+    auto is_swap_cell = [&](int x, int y) {
+        return (x == swap_a.x && y == swap_a.y) || (x == swap_b.x && y == swap_b.y);
+    };
+
+    const size_t limit = out_created.size() + kMaxCreatedPerStep;
+    runs.ForEachSet([&](int i) {
+        if (visited.Test(i) || out_created.size() >= limit) return;
+
+        const CellType c = cells_[i];
+        int best = -1;
+        int best_rank = 0;
+        Special best_special = Special::None;
+        visited.Set(i);
+        stack.push_back(i);
+        while (!stack.empty())
+        {
+            const int j = stack.back();
+            stack.pop_back();
+            const int x = j % Width();
+            const int y = j / Width();
+
+            const Special s = shape(x, y, c);
+            const int rank = kSpecialRank[static_cast<int>(s)] * 2 + (is_swap_cell(x, y) ? 1 : 0);
+            if (s != Special::None && rank > best_rank)
+            {
+                best = j;
+                best_rank = rank;
+                best_special = s;
+            }
+
+            const IVec2 next[4] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+            for (const IVec2 & n : next)
+            {
+                if (in_run(n.x, n.y, c) && !visited.Test(Index(n)))
+                {
+                    visited.Set(Index(n));
+                    stack.push_back(Index(n));
+                }
+            }
+        }
+
+        if (best >= 0)
+        {
+            const CellType type = (best_special == Special::ColorBomb) ? CellType::ColorBomb : c;
+            out_created.push_back(Transform{IVec2{best % Width(), best / Width()}, type, best_special});
+        }
+    });
+}
+
+// Adds the area of every special in 'mask' that has not fired yet, until no
+// new special is reached. A color bomb reached this way clears the most
+// common color around it. After kMaxFiredPerStep specials the rest are
+// marked fired and cleared without effect, so a chain cannot go on forever.
+template <int W, int H>
+void BasicBoard<W, H>::FireSpecials(Mask & mask, Mask & fired)
+{
+    int budget = kMaxFiredPerStep;
+    for (bool any = true; any;)
+    {
+        any = false;
+        for (int w = 0; w < mask.WordCount(); ++w)
+        {
+            uint64_t bits = mask.Word(w) & ~fired.Word(w);
+            while (bits)
+            {
+                const int i = w * 64 + std::countr_zero(bits);
+                bits &= bits - 1;
+                if (specials_[i] == Special::None)
+                {
+                    continue;
+                }
+                fired.Set(i);
+                if (budget == 0)
+                {
+                    continue;
+                }
+                --budget;
+                any = true;
+
+                const int x = i % Width();
+                const int y = i / Width();
+                switch (specials_[i])
+                {
+                    case Special::StripedH:
+                        MarkArea(mask, x, y, true, false);
+                        break;
+                    case Special::StripedV:
+                        MarkArea(mask, x, y, false, true);
+                        break;
+                    case Special::Wrapped:
+                        for (int yy = std::max(0, y - 1); yy <= std::min(Height() - 1, y + 1); ++yy)
+                        {
+                            for (int xx = std::max(0, x - 1); xx <= std::min(Width() - 1, x + 1); ++xx)
+                            {
+                                mask.Set(Index({xx, yy}));
+                            }
+                        }
+                        break;
+                    case Special::ColorBomb:
+                        MarkArea(mask, x, y, true, true, &planes_[static_cast<int>(MostCommonColor())]);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+}
+
+// Without 'vertical' this is the row segment through (x, y), without
+// 'horizontal' the column segment, with both the square around it.
+template <int W, int H>
+void BasicBoard<W, H>::MarkArea(Mask & mask, int x, int y, bool horizontal, bool vertical, const Mask * plane) const
+{
+    const int x0 = horizontal ? std::max(0, x - kSpecialReach) : x;
+    const int x1 = horizontal ? std::min(Width() - 1, x + kSpecialReach) : x;
+    const int y0 = vertical ? std::max(0, y - kSpecialReach) : y;
+    const int y1 = vertical ? std::min(Height() - 1, y + kSpecialReach) : y;
+    for (int yy = y0; yy <= y1; ++yy)
+    {
+        for (int xx = x0; xx <= x1; ++xx)
+        {
+            const int j = Index({xx, yy});
+            if (!plane || plane->Test(j)) mask.Set(j);
+        }
+    }
+}
+
+template <int W, int H>
+CellType BasicBoard<W, H>::MostCommonColor() const
+{
+    int best = 0;
+    int best_count = -1;
+    for (int c = 0; c < kColors; ++c)
+    {
+        const int n = planes_[c].Count();
+        if (n > best_count)
+        {
+            best = c;
+            best_count = n;
+        }
+    }
+    return static_cast<CellType>(best);
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::CollapseAndRefillPlanned(const Mask & mask,
+                                               std::vector<Move> & out_moves,
+                                               std::vector<Spawn> & out_spawns)
+{
+    out_moves.resize(Cells());
+    out_spawns.resize(Cells());
+    int moves = 0;
+    const int removed = CollapseAndRefill(mask, out_moves.data(), out_spawns.data(), moves);
+    out_moves.resize(moves);
+    out_spawns.resize(removed);
+    return removed;
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::CollapseAndRefill(const Mask & mask, Move * out_moves, Spawn * out_spawns, int & out_move_count)
+{
+    std::array<CellType, kDynamic ? kMaxBoardSide : H> colors;
+    const int words = (Height() + 63) / 64;
+
+    // Scatter the cleared cells into per-column bit words (row y at bit y % 64
+    // of word y / 64); only set bits are visited, so untouched columns and
+    // rows cost nothing beyond the mask scan.
+    mask.ForEachSet([&](int i) {
+        const int y = i / Width();
+        column_gone_[(i - y * Width()) * words + (y >> 6)] |= uint64_t{1} << (y & 63);
+    });
+
+    int removed = 0;
+    int moves = 0;
+    int lowest_changed = -1;
+    for (int x = 0; x < Width(); ++x)
+    {
+        uint64_t * gone_bits = &column_gone_[x * words];
+        int gone = 0;
+        int low = -1;
+        for (int w = words - 1; w >= 0; --w)
+        {
+            gone += std::popcount(gone_bits[w]);
+            if (low < 0 && gone_bits[w]) low = w * 64 + 63 - std::countl_zero(gone_bits[w]);
+        }
+
+        // Everything from the top down to the lowest removed cell changed.
+        column_low_[x] = low;
+        if (gone == 0)
+        {
+            continue;
+        }
+        dirty_cols_.Set(x);
+        lowest_changed = std::max(lowest_changed, low);
+        removed += gone;
+
+        // Cells below 'low' stay; every survivor above it moves, and they
+        // pack down in order, so the plan comes straight from the set bits
+        // of the survivors, highest row first.
+        int write_y = low;
+        for (int w = low >> 6; w >= 0; --w)
+        {
+            uint64_t keep = ~gone_bits[w];
+            if (w == (low >> 6)) keep &= (uint64_t{1} << (low & 63)) - 1;
+            while (keep)
+            {
+                const int bit = 63 - std::countl_zero(keep);
+                keep ^= uint64_t{1} << bit;
+                const int y = w * 64 + bit;
+                const int from = y * Width() + x;
+                out_moves[moves++] = Move{IVec2{x, y}, IVec2{x, write_y}};
+                SetCell(write_y * Width() + x, cells_[from], specials_[from]);
+                --write_y;
+            }
+        }
+
+        // Rows 0..gone-1 are empty now; refill them top-down from the column's stream.
+        DrawSpawnColors(x, gone, colors.data());
+        for (int i = 0; i < gone; ++i)
+        {
+            const int y = write_y - i;
+            SetCell(y * Width() + x, colors[i]);
+            out_spawns[i] = Spawn{IVec2{x, y}, colors[i], i};
+        }
+        out_spawns += gone;
+        std::fill(gone_bits, gone_bits + words, 0);
+    }
+
+    for (int y = 0; y <= lowest_changed; ++y)
+    {
+        dirty_rows_.Set(y);
+    }
+
+    // A swap with origin column ox reads columns ox-2..ox+3, down to two rows
+    // below its own; refresh each origin column once, as deep as its
+    // neighborhood changed.
+    for (int ox = 0; ox < Width(); ++ox)
+    {
+        int low = -1;
+        for (int x = std::max(0, ox - 2); x <= std::min(Width() - 1, ox + 3); ++x)
+        {
+            low = std::max(low, column_low_[x]);
+        }
+        if (low >= 0)
+        {
+            RefreshMoves(ox, 0, ox, low + 2);
+        }
+    }
+
+    out_move_count = moves;
+    return removed;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::ApplyMoveAndResolve(const IVec2 & a, const IVec2 & b, Resolution & out, int max_steps)
+{
+    out.valid = false;
+    out.complete = true;
+    out.score = 0;
+    out.cleared = 0;
+    out.step_count = 0;
+    out.move_count = 0;
+    out.spawn_count = 0;
+    out.steps.clear();
+    out.created.clear();
+
+    if (!InBounds(a) || !InBounds(b) || !AreAdjacent(a, b))
+    {
+        return false;
+    }
+
+    Swap(a, b);
+    for (;;)
+    {
+        if (out.step_count >= std::max(1, max_steps))
+        {
+            // Matches left over stay in the dirty set for the next scan.
+            thread_local Mask rest;
+            int groups = 0;
+            int cells = 0;
+            out.complete = !FindMatchesDirty(rest, groups, cells);
+            break;
+        }
+        if (static_cast<int>(out.masks.size()) <= out.step_count)
+        {
+            out.masks.emplace_back();
+        }
+        Mask & mask = out.masks[out.step_count];
+
+        CascadeStep step;
+        step.created_begin = static_cast<int>(out.created.size());
+        const bool first = (out.step_count == 0);
+        if (!ResolveMatches(mask, step.groups, step.cells, out.created, first ? a : kNoCell, first ? b : kNoCell))
+        {
+            break;
+        }
+        step.created_end = static_cast<int>(out.created.size());
+
+        step.score = MatchScore(step.cells, step.groups);
+        // The kernel needs room for a full board of each; the buffers only grow.
+        if (static_cast<int>(out.moves.size()) < out.move_count + Cells())
+        {
+            out.moves.resize(out.move_count + Cells());
+        }
+        if (static_cast<int>(out.spawns.size()) < out.spawn_count + Cells())
+        {
+            out.spawns.resize(out.spawn_count + Cells());
+        }
+        int moves = 0;
+        step.moves_begin = out.move_count;
+        step.spawns_begin = out.spawn_count;
+        out.spawn_count += CollapseAndRefill(mask, out.moves.data() + out.move_count,
+                                             out.spawns.data() + out.spawn_count, moves);
+        out.move_count += moves;
+        step.moves_end = out.move_count;
+        step.spawns_end = out.spawn_count;
+
+        out.score += step.score;
+        out.cleared += step.cells;
+        out.steps.push_back(step);
+        ++out.step_count;
+    }
+
+    out.valid = out.step_count > 0;
+    if (!out.valid)
+    {
+        Swap(b, a);
+    }
+    return out.valid && out.complete;
+}
+
+template <int W, int H>
+std::optional<std::pair<IVec2, IVec2>> BasicBoard<W, H>::FindAnySwap() const
+{
+    if (move_count_ == 0)
+    {
+        return std::nullopt;
+    }
+
+    // First valid swap in scan order (row-major, right before down).
+    for (int w = 0; w < swap_right_.WordCount(); ++w)
+    {
+        const uint64_t any = swap_right_.Word(w) | swap_down_.Word(w);
+        if (!any) continue;
+
+        const int i = w * 64 + std::countr_zero(any);
+        const IVec2 a{i % Width(), i / Width()};
+        if (swap_right_.Test(i))
+        {
+            return std::make_pair(a, IVec2{a.x + 1, a.y});
+        }
+        return std::make_pair(a, IVec2{a.x, a.y + 1});
+    }
+
+    return std::nullopt;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::IsValidSwap(const IVec2 & a, const IVec2 & b) const
+{
+    if (!InBounds(a) || !InBounds(b) || !AreAdjacent(a, b))
+    {
+        return false;
+    }
+    const IVec2 & o = (a.x + a.y < b.x + b.y) ? a : b;
+    const int idx = Index(o);
+    return (a.y == b.y) ? swap_right_.Test(idx) : swap_down_.Test(idx);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::Shuffle()
+{
+    // What is on the board: candies per color (bombs last) and, per color,
+    // the striped and wrapped specials that ride on them.
+    std::array<int, kPlanes> left {};
+    thread_local std::array<std::vector<Special>, kColors> carried;
+    for (auto & v : carried) v.clear();
+    for (int i = 0; i < Cells(); ++i)
+    {
+        const int c = static_cast<int>(cells_[i]);
+        ++left[c];
+        if (c < kColors && specials_[i] != Special::None) carried[c].push_back(specials_[i]);
+    }
+
+    thread_local std::vector<uint8_t> colors;
+    thread_local std::vector<int> order;
+    colors.assign(Cells(), kUnsetColor);
+
+    // Bombs go to random cells first; any one of them is a valid swap, so a
+    // move only has to be planted when there is none.
+    const int bombs = left[kColors];
+    order.resize(Cells());
+    for (int i = 0; i < Cells(); ++i) order[i] = i;
+    for (int i = 0; i < bombs; ++i)
+    {
+        const int j = i + static_cast<int>(UniformBelow(rng_, static_cast<uint32_t>(Cells() - i)));
+        std::swap(order[i], order[j]);
+        colors[order[i]] = static_cast<uint8_t>(kColors);
+    }
+    if (bombs == 0)
+    {
+        const int box = static_cast<int>(UniformBelow(rng_, static_cast<uint32_t>(MaxPlantedMoves())));
+        if (!PlantMove(colors, box))
+        {
+            return false;
+        }
+        // The middle column of the box holds one planted cell, the other is unset.
+        const int bx = (box % (Width() / 3)) * 3;
+        const int by = (box / (Width() / 3)) * 2;
+        const int planted = std::min(colors[Index({bx + 1, by})], colors[Index({bx + 1, by + 1})]);
+        left[planted] = std::max(0, left[planted] - 3);
+    }
+
+    for (int y = 0; y < Height(); ++y)
+    {
+        for (int x = 0; x < Width(); ++x)
+        {
+            uint8_t & c = colors[Index({x, y})];
+            if (c == kUnsetColor)
+            {
+                c = PickRemaining(kAllColors & ~ExcludedColors(colors, x, y), left);
+                left[c] = std::max(0, left[c] - 1);
+            }
+        }
+    }
+
+    // Each special lands on a uniformly random candy of its color among those
+    // placed from here on (placement order does not matter for that).
+    std::array<int, kColors> seen {};
+    for (int i = 0; i < Cells(); ++i)
+    {
+        if (colors[i] < kColors) ++seen[colors[i]];
+    }
+    for (int i = 0; i < Cells(); ++i)
+    {
+        const int c = colors[i];
+        Special s = (c == kColors) ? Special::ColorBomb : Special::None;
+        if (c < kColors)
+        {
+            auto & pool = carried[c];
+            if (!pool.empty() && UniformBelow(rng_, static_cast<uint32_t>(seen[c])) < pool.size())
+            {
+                s = pool.back();
+                pool.pop_back();
+            }
+            --seen[c];
+        }
+        SetCell(i, static_cast<CellType>(c), s);
+    }
+    MarkAllDirty();
+    RefreshMoves(0, 0, Width() - 1, Height() - 1);
+
+    Mask mask;
+    int groups = 0;
+    int cells = 0;
+    return move_count_ > 0 && !FindMatches(mask, groups, cells);
+}
+
+// Weighted pick: colors with more candies left are likelier, so the shuffled
+// board keeps the counts it had wherever the run rules allow.
+template <int W, int H>
+uint8_t BasicBoard<W, H>::PickRemaining(uint32_t allowed, const std::array<int, kPlanes> & left)
+{
+    int total = 0;
+    for (uint32_t bits = allowed; bits; bits &= bits - 1) total += left[std::countr_zero(bits)];
+    if (total == 0)
+    {
+        return PickColor(allowed);
+    }
+    int k = static_cast<int>(UniformBelow(rng_, static_cast<uint32_t>(total)));
+    for (uint32_t bits = allowed;; bits &= bits - 1)
+    {
+        const int c = std::countr_zero(bits);
+        if (k < left[c]) return static_cast<uint8_t>(c);
+        k -= left[c];
+    }
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::EnsurePlayable()
+{
+    if (move_count_ > 0)
+    {
+        return true;
+    }
+    return Shuffle();
+}
+
+template <int W, int H>
+int BasicBoard<W, H>::Index(const IVec2 & p) const
+{
+    return p.y * Width() + p.x;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::SetCell(int idx, CellType c, Special s)
+{
+    planes_[static_cast<int>(cells_[idx])].Reset(idx);
+    planes_[static_cast<int>(c)].Set(idx);
+    hash_ ^= ZobristKey(idx, cells_[idx], specials_[idx]) ^ ZobristKey(idx, c, s);
+    cells_[idx] = c;
+    specials_[idx] = s;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::MarkDirty(const IVec2 & p)
+{
+    dirty_rows_.Set(p.y);
+    dirty_cols_.Set(p.x);
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::FormsRun(const IVec2 & p, CellType c, const IVec2 & from) const
+{
+    if (c == CellType::ColorBomb)
+    {
+        return false;
+    }
+
+    // Windows of two cells either side, placed so p lands on bit 4 of the
+    // run length table. p gets the candy; 'from' holds the other swapped
+    // candy afterwards, so it always breaks the run.
+    const Mask & plane = planes_[static_cast<int>(c)];
+    uint32_t h = (RowWindow(plane, p.x, p.y, 2) << 2) | 16u;
+    uint32_t v = (ColumnWindow(plane, p.x, p.y, 2) << 2) | 16u;
+    if (from.y == p.y) h &= ~(1u << (from.x - p.x + 4));
+    else v &= ~(1u << (from.y - p.y + 4));
+    return kRunLength[h] >= 3 || kRunLength[v] >= 3;
+}
+
+template <int W, int H>
+uint32_t BasicBoard<W, H>::RowWindow(const Mask & mask, int x, int y, int r) const
+{
+    const int lo = std::max(0, x - r);
+    const int hi = std::min(Width() - 1, x + r);
+    const int start = Index({lo, y});
+    const int len = hi - lo + 1;
+
+    const int w = start >> 6;
+    const int offset = start & 63;
+    uint64_t bits = mask.Word(w) >> offset;
+    if (offset + len > 64)
+    {
+        bits |= mask.Word(w + 1) << (64 - offset);
+    }
+    bits &= (uint64_t{1} << len) - 1;
+    return static_cast<uint32_t>(bits << (lo - (x - r)));
+}
+
+template <int W, int H>
+uint32_t BasicBoard<W, H>::ColumnWindow(const Mask & mask, int x, int y, int r) const
+{
+    const int lo = std::max(0, y - r);
+    const int hi = std::min(Height() - 1, y + r);
+    uint32_t bits = 0;
+    for (int k = lo; k <= hi; ++k)
+    {
+        bits |= static_cast<uint32_t>(mask.Test(Index({x, k}))) << (k - (y - r));
+    }
+    return bits;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::SwapMakesMatch(const IVec2 & a, const IVec2 & b) const
+{
+    const CellType ca = cells_[Index(a)];
+    const CellType cb = cells_[Index(b)];
+    if (ca == CellType::ColorBomb || cb == CellType::ColorBomb)
+    {
+        return true;
+    }
+    if (ca == cb)
+    {
+        return false;
+    }
+    return FormsRun(b, ca, a) || FormsRun(a, cb, b);
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::SetSwapBit(Mask & mask, int idx, bool valid)
+{
+    if (mask.Test(idx) == valid)
+    {
+        return;
+    }
+    if (valid)
+    {
+        mask.Set(idx);
+        ++move_count_;
+    }
+    else
+    {
+        mask.Reset(idx);
+        --move_count_;
+    }
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::RefreshMoves(int x0, int y0, int x1, int y1)
+{
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, Width() - 1);
+    y1 = std::min(y1, Height() - 1);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const int idx = Index({x, y});
+            SetSwapBit(swap_right_, idx, x + 1 < Width() && SwapMakesMatch({x, y}, {x + 1, y}));
+            SetSwapBit(swap_down_, idx, y + 1 < Height() && SwapMakesMatch({x, y}, {x, y + 1}));
+        }
+    }
+}
+
+// Scalar run scan along one line of 'count' cells starting at 'start' and
+// advancing by 'step'. Marks runs of 3+ in out_mask and returns how many there were.
+template <int W, int H>
+int BasicBoard<W, H>::ScanLine(int start, int step, int count, Mask & out_mask) const
+{
+    int groups = 0;
+    int run_len = 1;
+    for (int k = 1; k <= count; ++k)
+    {
+        const CellType c = cells_[start + (k - 1) * step];
+        const bool same = (k < count) && c != CellType::ColorBomb && cells_[start + k * step] == c;
+        if (same)
+        {
+            ++run_len;
+            continue;
+        }
+        if (run_len >= 3)
+        {
+            ++groups;
+            for (int j = k - run_len; j < k; ++j)
+            {
+                out_mask.Set(start + j * step);
+            }
+        }
+        run_len = 1;
+    }
+    return groups;
+}
+
+template <int W, int H>
+bool BasicBoard<W, H>::FindMatchesMask(Mask & out_mask, int & out_groups, int & out_cells) const
+{
+    constexpr int kWords = Mask::kWords;
+    const int words = out_mask.WordCount();
+    KernelScratch<kWords> scratch(words);
+
+    for (int c = 0; c < kColors; ++c)
+    {
+        out_groups += DetectRuns<kWords>(planes_[c].Data(), this->RunOriginsH().Data(), this->NotFirstColumn().Data(),
+                                         words, Width(), scratch, out_mask.Data());
+    }
+
+    out_cells = out_mask.Count();
+    return out_cells > 0;
+}
+
+template <int W, int H>
+void BasicBoard<W, H>::DrawSpawnColors(int x, int count, CellType * out)
+{
+    // A local view of the column's stream computes each Philox block once
+    // for four draws, instead of once per draw.
+    CounterRng stream(rng_.Key(), 1 + static_cast<uint64_t>(x));
+    stream.SetPosition(spawn_draws_[x]);
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = static_cast<CellType>(UniformBelow(stream, kColors));
+    }
+    spawn_draws_[x] = stream.Position();
+}
+
+template class BasicBoard<6, 6>;
+template class BasicBoard<8, 8>;
+template class BasicBoard<9, 9>;
+template class BasicBoard<kDynamicSize, kDynamicSize>;
@@ -0,0 +1,375 @@
+#pragma once
+#include "types.h"
+#include "bitmask.h"
+#include "zobrist.h"
+#include "rng.h"
+
+#include <array>
+#include <vector>
+#include <optional>
+#include <string>
+#include <utility>
+#include <type_traits>
+
+struct Move
+{
+    IVec2 from;
+    IVec2 to;
+};
+
+struct Spawn
+{
+    IVec2 to;
+    CellType type;
+    int order_above {0}; // 0,1,2... for stacking spawn start offsets
+};
+
+// Score awarded for one match step. 64-bit: cascades on large boards go far
+// past what an int holds.
+inline int64_t MatchScore(int cells, int groups)
+{
+    return static_cast<int64_t>(cells) * groups;
+}
+
+// Placeholder for "no cell", e.g. when matches are not caused by a swap.
+inline constexpr IVec2 kNoCell {-1, -1};
+
+// A matched cell that stays on the board, turned into a special candy.
+struct Transform
+{
+    IVec2 at;
+    CellType type;
+    Special special;
+};
+
+// One match/collapse step of a resolved move. Ranges index MoveResolution::moves/spawns/created.
+struct CascadeStep
+{
+    int groups {0};
+    int cells {0};
+    int64_t score {0};
+    int moves_begin {0};
+    int moves_end {0};
+    int spawns_begin {0};
+    int spawns_end {0};
+    int created_begin {0};
+    int created_end {0};
+};
+
+// Everything ApplyMoveAndResolve did, step by step. Meant to be kept and
+// reused: containers are cleared, never shrunk, so once they have grown to
+// the longest cascade seen, resolving a move allocates nothing.
+template <typename MaskT>
+struct MoveResolution
+{
+    bool valid {false};   // false: no match, the swap was reverted
+    bool complete {true}; // false: stopped at the step limit with matches left
+    int64_t score {0};
+    int cleared {0};
+    int step_count {0};
+    int move_count {0};
+    int spawn_count {0};
+    std::vector<CascadeStep> steps;
+    std::vector<MaskT> masks;    // masks[i]: cells removed by step i; only the first step_count are current
+    std::vector<Move> moves;     // all steps, in order; only the first move_count are current
+    std::vector<Spawn> spawns;   // only the first spawn_count are current
+    std::vector<Transform> created;
+};
+
+// Template argument for boards whose dimensions are chosen at runtime.
+inline constexpr int kDynamicSize = 0;
+
+// Largest side supported by the runtime-sized board.
+inline constexpr int kMaxBoardSide = 4096;
+
+// Default cap on the match/collapse steps of one resolved move. Each step
+// keeps a mask and its moves, so this also bounds the memory a move can take.
+inline constexpr int kMaxCascadeSteps = 512;
+
+// Limits that keep special candies local on large boards, so a cascade stays
+// bounded however many specials it meets. A striped candy clears up to
+// kSpecialReach cells to each side and a chained color bomb only reaches its
+// color within that distance; both cover the whole board up to 17 cells wide.
+// One match step creates at most kMaxCreatedPerStep specials and fires at
+// most kMaxFiredPerStep; the ones past that are cleared without firing.
+inline constexpr int kSpecialReach = 16;
+inline constexpr int kMaxCreatedPerStep = 8;
+inline constexpr int kMaxFiredPerStep = 16;
+
+// Board dimensions plus the constant line masks the match kernels need.
+// Fixed boards get both as compile-time constants; dynamic boards carry them as members.
+template <int W, int H>
+struct BoardShape
+{
+    using Mask = BitMask<W * H>;
+
+    static constexpr int Width() { return W; }
+    static constexpr int Height() { return H; }
+
+    // Cells that may start a horizontal triple (x <= Width() - 3).
+    static constexpr Mask kRunOriginsH = Mask::Columns(W, H, 0, W - 3);
+    // Every cell except column 0 (stops run starts leaking across rows).
+    static constexpr Mask kNotFirstColumn = Mask::Columns(W, H, 1, W - 1);
+
+    static constexpr const Mask & RunOriginsH() { return kRunOriginsH; }
+    static constexpr const Mask & NotFirstColumn() { return kNotFirstColumn; }
+};
+
+template <>
+struct BoardShape<kDynamicSize, kDynamicSize>
+{
+    using Mask = BitMask<kDynamicBits>;
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+
+    const Mask & RunOriginsH() const { return run_origins_h_; }
+    const Mask & NotFirstColumn() const { return not_first_column_; }
+
+protected:
+    int width_ {0};
+    int height_ {0};
+    Mask run_origins_h_;
+    Mask not_first_column_;
+};
+
+// Match-three board. W x H fixes the size at compile time so every kernel is
+// specialized and unrolled for it; BasicBoard<kDynamicSize, kDynamicSize>
+// takes its size at construction and shares the same API.
+//
+// Only the aliases below are instantiated (in board.cpp); other fixed sizes
+// should use DynamicBoard.
+template <int W, int H>
+class BasicBoard : public BoardShape<W, H>
+{
+    static_assert((W == kDynamicSize) == (H == kDynamicSize),
+                  "Either both dimensions are fixed or both are dynamic");
+
+public:
+    static constexpr bool kDynamic = (W == kDynamicSize);
+    static constexpr int kWidth = W;              // 0 for dynamic boards
+    static constexpr int kHeight = H;             // 0 for dynamic boards
+    static constexpr int kCells = W * H;          // 0 for dynamic boards
+    static constexpr int kColors = static_cast<int>(CellType::Count);
+    // Color planes plus one for color bombs.
+    static constexpr int kPlanes = kColors + 1;
+
+    // One bit per cell, indexed y * Width() + x.
+    using Mask = typename BoardShape<W, H>::Mask;
+    // One bit per row / per column.
+    using RowMask = BitMask<kDynamic ? kDynamicBits : H>;
+    using ColumnMask = BitMask<kDynamic ? kDynamicBits : W>;
+
+    using Resolution = MoveResolution<Mask>;
+
+    using BoardShape<W, H>::Width;
+    using BoardShape<W, H>::Height;
+
+    BasicBoard();
+    // Fixed boards assert that the arguments match W x H.
+    BasicBoard(int width, int height);
+
+    int Cells() const { return Width() * Height(); }
+
+    // Builds a board with no matches and at least min(min_moves, MaxPlantedMoves())
+    // valid swaps, in one pass without retries: move patterns are planted
+    // first, then every other cell picks among the colors that complete no run.
+    void GenerateInitial(uint32_t seed, int min_moves = 1);
+    // One move pattern fits in each 3x2 box of the board.
+    int MaxPlantedMoves() const { return (Width() / 3) * (Height() / 2); }
+
+    // Raw logical state, for keyframes and save games. LoadCells expects
+    // Cells() entries (no specials if 'specials' is null), rebuilds all
+    // derived state and marks everything dirty.
+    // RngState is a compact binary blob (key and stream positions).
+    const CellType * CellData() const { return cells_.data(); }
+    const Special * SpecialData() const { return specials_.data(); }
+    void LoadCells(const CellType * cells, const Special * specials = nullptr);
+    std::string RngState() const;
+    bool SetRngState(const std::string & state);
+    // The same state as 2 + Width() words (key, stream 0 position, column
+    // positions), for bulk copies without the string.
+    void GetRngWords(uint64_t * out) const;
+    void SetRngWords(const uint64_t * words);
+    // Restarts every random stream under a new key (GenerateInitial does this).
+    void SeedRng(uint64_t seed);
+
+    // Cell and special copy for search. Restore leaves the RNG alone, so the refills
+    // that follow keep drawing from this board's own stream.
+    using CellStore = std::conditional_t<kDynamic, std::vector<CellType>, std::array<CellType, kCells>>;
+    using SpecialStore = std::conditional_t<kDynamic, std::vector<Special>, std::array<Special, kCells>>;
+    struct Snapshot
+    {
+        CellStore cells;
+        SpecialStore specials;
+    };
+    Snapshot TakeSnapshot() const { return {cells_, specials_}; }
+    void Restore(const Snapshot & snapshot) { LoadCells(snapshot.cells.data(), snapshot.specials.data()); }
+
+    // Zobrist hash of the cells and specials (see zobrist.h), maintained on every change.
+    uint64_t Hash() const { return hash_; }
+
+    bool InBounds(const IVec2 & p) const;
+    CellType Get(const IVec2 & p) const;
+    Special GetSpecial(const IVec2 & p) const;
+    void Set(const IVec2 & p, CellType c, Special s = Special::None);
+
+    bool AreAdjacent(const IVec2 & a, const IVec2 & b) const;
+
+    // Low-level swap (used by the state machine).
+    void Swap(const IVec2 & a, const IVec2 & b);
+
+    // Public match finding. Returns true if any matches were found and
+    // fills out_mask with matched cells. Additionally outputs the number
+    // of distinct match groups and total matched cells for scoring.
+    bool FindMatches(Mask & out_mask, int & out_groups, int & out_cells) const;
+
+    // Same result as FindMatches, but only examines rows and columns touched
+    // since the last scan that came back clean: dirty rows for horizontal runs,
+    // dirty columns (within two cells of the dirty row span) for vertical runs.
+    // Swap, Set and CollapseAndRefillPlanned mark lines dirty. The dirty set is
+    // retired only when no match is found, so the result is exact no matter
+    // what the caller does with the matches.
+    bool FindMatchesDirty(Mask & out_mask, int & out_groups, int & out_cells);
+
+    // Forces the next FindMatchesDirty to scan the whole board.
+    void MarkAllDirty();
+
+    // One match step with special candies, on top of FindMatchesDirty:
+    //  - each same-color connected group of run cells with a run of 4 or 5,
+    //    or a horizontal and a vertical run crossing (L/T), leaves one special
+    //    candy behind (appended to out_created and already on the board);
+    //  - a color bomb swapped with 'swap_a'/'swap_b' clears the other color;
+    //  - specials in the cleared cells fire, chaining into each other.
+    // Areas, creation and chains are bounded (kSpecialReach and friends).
+    // out_mask then holds every cell to collapse and 'cells' its count.
+    // Returns false (nothing changed) when there is nothing to clear.
+    bool ResolveMatches(Mask & out_mask, int & out_groups, int & out_cells,
+                        std::vector<Transform> & out_created,
+                        const IVec2 & swap_a = kNoCell, const IVec2 & swap_b = kNoCell);
+
+    // Collapse columns and refill with new candies. Specials fall with their candy.
+    // Mutates the board to the post-collapse state and returns planned tile moves and spawns.
+    int CollapseAndRefillPlanned(const Mask & mask,
+                                 std::vector<Move> & out_moves,
+                                 std::vector<Spawn> & out_spawns);
+
+    // The kernel behind CollapseAndRefillPlanned, writing the plan into
+    // caller-owned buffers with room for Cells() entries each. Columns are
+    // compacted from bit masks (no per-cell branch) and each column's spawn
+    // colors are drawn in one batch. Returns the number of removed cells,
+    // which is also the number of spawns; out_move_count gets the moves.
+    int CollapseAndRefill(const Mask & mask, Move * out_moves, Spawn * out_spawns, int & out_move_count);
+
+    // Swaps a and b, then matches, collapses and refills until the board is
+    // stable, recording every step in 'out'. Reverts the swap when it makes no
+    // match. Does not reshuffle a deadlocked board (see EnsurePlayable).
+    // Stops after max_steps steps even if matches are left: out.complete is
+    // then false and the board keeps them (the next scan finds them again).
+    // Returns out.valid && out.complete.
+    bool ApplyMoveAndResolve(const IVec2 & a, const IVec2 & b, Resolution & out,
+                             int max_steps = kMaxCascadeSteps);
+
+    // Find any possible swap that would produce a match.
+    // Returns the pair of coordinates to swap if available.
+    std::optional<std::pair<IVec2, IVec2>> FindAnySwap() const;
+
+    // Valid swaps are tracked incrementally: every mutation re-evaluates only
+    // the swaps whose outcome can depend on the changed cells. A swap is valid
+    // when it puts one of the two swapped candies into a run of 3+, or when it
+    // involves a color bomb.
+    int ValidMoveCount() const { return move_count_; }
+    bool HasValidMove() const { return move_count_ > 0; }
+    bool IsValidSwap(const IVec2 & a, const IVec2 & b) const;
+
+    // Calls fn(a, b) for every valid swap, b being the right or lower neighbor of a.
+    template <typename Fn>
+    void ForEachValidSwap(Fn && fn) const
+    {
+        swap_right_.ForEachSet([&](int i) { fn(IVec2{i % Width(), i / Width()}, IVec2{i % Width() + 1, i / Width()}); });
+        swap_down_.ForEachSet([&](int i) { fn(IVec2{i % Width(), i / Width()}, IVec2{i % Width(), i / Width() + 1}); });
+    }
+
+    // Redistributes the candies into a position with no matches and at least
+    // one valid swap, in one pass like GenerateInitial: a move is planted
+    // (unless a color bomb already gives one), then every other cell draws from
+    // the remaining candies among the colors that complete no run, or gets a
+    // new candy when none of those is left. Specials stay with their color.
+    // Returns false if the result is not playable.
+    bool Shuffle();
+
+    // Shuffles when the board is deadlocked. Returns false if the board is
+    // still deadlocked afterwards; callers must not expect a valid move then.
+    bool EnsurePlayable();
+
+private:
+    CellStore cells_ {};
+    SpecialStore specials_ {};
+    // planes_[c] has a bit set for every cell holding CellType c (the last
+    // plane: color bombs). Kept in sync with cells_.
+    std::array<Mask, kPlanes> planes_ {};
+    // Specials that went off in the current step, scratch for ResolveMatches.
+    Mask fired_ {};
+    RowMask dirty_rows_ {};
+    ColumnMask dirty_cols_ {};
+    // Bit i set: swapping cell i with its right (resp. lower) neighbor is valid.
+    Mask swap_right_ {};
+    Mask swap_down_ {};
+    int move_count_ {0};
+    uint64_t hash_ {0};
+    // Per-column lowest changed row, scratch for CollapseAndRefillPlanned.
+    std::conditional_t<kDynamic, std::vector<int>, std::array<int, W>> column_low_ {};
+    // Per-column cleared-row bits, (Height() + 63) / 64 words per column;
+    // scratch for CollapseAndRefill, all zero between calls.
+    std::conditional_t<kDynamic, std::vector<uint64_t>, std::array<uint64_t, W * ((H + 63) / 64)>> column_gone_ {};
+    // Philox streams under one key: stream 0 (rng_) feeds initial generation
+    // and shuffles, stream 1 + x the refills of column x. Spawns in a column
+    // therefore depend only on the key and how many that column has had.
+    CounterRng rng_;
+    std::conditional_t<kDynamic, std::vector<uint64_t>, std::array<uint64_t, W>> spawn_draws_ {};
+
+    int Index(const IVec2 & p) const;
+    void SetCell(int idx, CellType c, Special s = Special::None);
+    void MarkDirty(const IVec2 & p);
+    int ScanLine(int start, int step, int count, Mask & out_mask) const;
+
+    bool SwapMakesMatch(const IVec2 & a, const IVec2 & b) const;
+    bool FormsRun(const IVec2 & p, CellType c, const IVec2 & from) const;
+    // Bits of 'mask' from x - r to x + r along row y (resp. from y - r to
+    // y + r along column x), cell (x, y) being bit r; zero off the board.
+    uint32_t RowWindow(const Mask & mask, int x, int y, int r) const;
+    uint32_t ColumnWindow(const Mask & mask, int x, int y, int r) const;
+    void SetSwapBit(Mask & mask, int idx, bool valid);
+    // Re-evaluates swaps whose origin (left/top cell) lies in [x0, x1] x [y0, y1].
+    void RefreshMoves(int x0, int y0, int x1, int y1);
+    void InitStorage();
+
+    // Internal helpers
+    bool FindMatchesMask(Mask & out_mask, int & out_groups, int & out_cells) const;
+    // Next 'count' refill colors of column x, from its own Philox stream.
+    void DrawSpawnColors(int x, int count, CellType * out);
+    // ResolveMatches helpers.
+    void ClassifyShapes(const Mask & runs, const IVec2 & swap_a, const IVec2 & swap_b,
+                        std::vector<Transform> & out_created) const;
+    void FireSpecials(Mask & mask, Mask & fired);
+    // Sets the cells within kSpecialReach of (x, y) along the given axes,
+    // only those of 'plane' if one is given.
+    void MarkArea(Mask & mask, int x, int y, bool horizontal, bool vertical, const Mask * plane = nullptr) const;
+    CellType MostCommonColor() const;
+    // GenerateInitial helpers; colors holds one byte per cell, kUnsetColor if unassigned.
+    uint32_t ExcludedColors(const std::vector<uint8_t> & colors, int x, int y) const;
+    bool PlantMove(std::vector<uint8_t> & colors, int box);
+    uint8_t PickColor(uint32_t allowed);
+    // Pick among 'allowed' weighted by left[c]; uniform if none is left.
+    uint8_t PickRemaining(uint32_t allowed, const std::array<int, kPlanes> & left);
+};
+
+using Board = BasicBoard<6, 6>;
+using Board8 = BasicBoard<8, 8>;
+using Board9 = BasicBoard<9, 9>;
+using DynamicBoard = BasicBoard<kDynamicSize, kDynamicSize>;
+
+extern template class BasicBoard<6, 6>;
+extern template class BasicBoard<8, 8>;
+extern template class BasicBoard<9, 9>;
+extern template class BasicBoard<kDynamicSize, kDynamicSize>;
@@ -0,0 +1,322 @@
+#include "board_batch.h"
+#include "board_batch_kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+
+#if defined(MATCH3_X86_KERNELS) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace
+{
+    // Cells of the lane being stored; LoadCells wants plain arrays. Reused
+    // per thread so storing a lane allocates nothing after the first call.
+    thread_local std::vector<CellType> t_cells;
+    thread_local std::vector<Special> t_specials;
+
+    // One lane at a time: the portable fallback.
+    struct ScalarLanes
+    {
+        using T = uint16_t;
+        static constexpr int kLanes = 1;
+
+        static T Load(const uint16_t * p) { return *p; }
+        static void Store(uint16_t * p, T v) { *p = v; }
+        static T Zero() { return 0; }
+        static T Splat(uint16_t v) { return v; }
+        static T And(T a, T b) { return static_cast<T>(a & b); }
+        static T Or(T a, T b) { return static_cast<T>(a | b); }
+        static T AndNot(T a, T b) { return static_cast<T>(a & ~b); }
+        static T Add(T a, T b) { return static_cast<T>(a + b); }
+        template <int K> static T Shl(T v) { return static_cast<T>(v << K); }
+        template <int K> static T Shr(T v) { return static_cast<T>(v >> K); }
+        static T Popcount(T v) { return static_cast<T>(std::popcount(v)); }
+        static bool Any(T v) { return v != 0; }
+    };
+
+    struct KernelSet
+    {
+        bool (*find_matches)(const BatchData &);
+        void (*count_moves)(const BatchData &);
+        void (*collapse)(const BatchData &);
+    };
+
+    const KernelSet & Kernels(BatchIsa isa)
+    {
+        static constexpr KernelSet kScalar {BatchFindMatchesScalar, BatchCountValidMovesScalar, BatchCollapseScalar};
+#if defined(MATCH3_X86_KERNELS)
+        static constexpr KernelSet kSse4 {BatchFindMatchesSse4, BatchCountValidMovesSse4, BatchCollapseSse4};
+        static constexpr KernelSet kAvx2 {BatchFindMatchesAvx2, BatchCountValidMovesAvx2, BatchCollapseAvx2};
+        switch (isa)
+        {
+            case BatchIsa::Sse4: return kSse4;
+            case BatchIsa::Avx2: return kAvx2;
+            case BatchIsa::Scalar: break;
+        }
+#else
+        (void)isa;
+#endif
+        return kScalar;
+    }
+
+    struct CpuFeatures
+    {
+        bool sse41 {false};
+        bool avx2 {false};
+    };
+
+    CpuFeatures DetectCpu()
+    {
+        CpuFeatures f;
+#if defined(MATCH3_X86_KERNELS)
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4] = {};
+        __cpuid(info, 0);
+        const int max_leaf = info[0];
+        __cpuid(info, 1);
+        f.sse41 = (info[2] & (1 << 19)) != 0;
+        // AVX2 also needs the OS to save the YMM registers.
+        const bool avx_os = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+        if (avx_os && max_leaf >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            f.avx2 = (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        f.sse41 = __builtin_cpu_supports("sse4.1");
+        f.avx2 = __builtin_cpu_supports("avx2");
+#endif
+#endif
+        return f;
+    }
+}
+
+bool BatchFindMatchesScalar(const BatchData & d) { return batch_kernels::FindMatches<ScalarLanes>(d); }
+void BatchCountValidMovesScalar(const BatchData & d) { batch_kernels::CountValidMoves<ScalarLanes>(d); }
+void BatchCollapseScalar(const BatchData & d) { batch_kernels::Collapse<ScalarLanes>(d); }
+
+const char * BatchIsaName(BatchIsa isa)
+{
+    switch (isa)
+    {
+        case BatchIsa::Scalar: return "scalar";
+        case BatchIsa::Sse4:   return "sse4.1";
+        case BatchIsa::Avx2:   return "avx2";
+    }
+    return "?";
+}
+
+bool BatchIsaSupported(BatchIsa isa)
+{
+    static const CpuFeatures cpu = DetectCpu();
+    switch (isa)
+    {
+        case BatchIsa::Scalar: return true;
+        case BatchIsa::Sse4:   return cpu.sse41;
+        case BatchIsa::Avx2:   return cpu.avx2;
+    }
+    return false;
+}
+
+BoardBatch::BoardBatch(int width, int height, int count)
+    : width_(width)
+    , height_(height)
+    , count_(count)
+    , lanes_((count + kBatchBlock - 1) / kBatchBlock * kBatchBlock)
+    , stride_(lanes_ + kBatchBlock)
+{
+    assert(width >= 3 && height >= 3 && width <= kMaxSide && height <= kMaxSide && count >= 0);
+    planes_.assign(static_cast<size_t>(kBatchPlanes) * height_ * stride_, 0);
+    matches_.assign(static_cast<size_t>(height_) * stride_, 0);
+    cells_.assign(lanes_, 0);
+    groups_.assign(lanes_, 0);
+    moves_.assign(lanes_, 0);
+    active_.assign(lanes_ / kBatchBlock, 1);
+    rng_.assign(static_cast<size_t>(lanes_) * (2 + width_), 0);
+
+    for (BatchIsa isa : {BatchIsa::Avx2, BatchIsa::Sse4})
+    {
+        if (SetIsa(isa)) break;
+    }
+}
+
+bool BoardBatch::SetIsa(BatchIsa isa)
+{
+    if (!BatchIsaSupported(isa))
+    {
+        return false;
+    }
+    isa_ = isa;
+    return true;
+}
+
+BatchData BoardBatch::Data()
+{
+    BatchData d;
+    d.width = width_;
+    d.height = height_;
+    d.lanes = lanes_;
+    d.stride = stride_;
+    d.planes = planes_.data();
+    d.matches = matches_.data();
+    d.cells = cells_.data();
+    d.groups = groups_.data();
+    d.moves = moves_.data();
+    d.active = active_.data();
+    return d;
+}
+
+template <int W, int H>
+void BoardBatch::Load(int lane, const BasicBoard<W, H> & board)
+{
+    assert(board.Width() == width_ && board.Height() == height_ && lane >= 0 && lane < count_);
+    // Rows are gathered locally first: in the batch every (plane, row) of a
+    // lane sits on a different cache line.
+    uint16_t rows[kBatchPlanes][kMaxSide] = {};
+    const CellType * cells = board.CellData();
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            rows[static_cast<int>(cells[y * width_ + x])][y] |= static_cast<uint16_t>(1u << x);
+        }
+    }
+    for (int c = 0; c < kBatchPlanes; ++c)
+    {
+        for (int y = 0; y < height_; ++y) planes_[PlaneAt(c, y, lane)] = rows[c][y];
+    }
+    board.GetRngWords(&rng_[static_cast<size_t>(lane) * (2 + width_)]);
+}
+
+template <int W, int H>
+void BoardBatch::Store(int lane, BasicBoard<W, H> & board) const
+{
+    assert(board.Width() == width_ && board.Height() == height_ && lane >= 0 && lane < count_);
+    t_cells.resize(static_cast<size_t>(board.Cells()));
+    t_specials.assign(static_cast<size_t>(board.Cells()), Special::None);
+    for (int y = 0; y < height_; ++y)
+    {
+        for (int x = 0; x < width_; ++x)
+        {
+            const CellType c = Get(lane, IVec2{x, y});
+            t_cells[y * width_ + x] = (c == kBatchEmpty) ? CellType::Red : c;
+            if (c == CellType::ColorBomb) t_specials[y * width_ + x] = Special::ColorBomb;
+        }
+    }
+    board.LoadCells(t_cells.data(), t_specials.data());
+    board.SetRngWords(&rng_[static_cast<size_t>(lane) * (2 + width_)]);
+}
+
+CellType BoardBatch::Get(int lane, const IVec2 & p) const
+{
+    for (int c = 0; c < kBatchPlanes; ++c)
+    {
+        if ((planes_[PlaneAt(c, p.y, lane)] >> p.x) & 1) return static_cast<CellType>(c);
+    }
+    return kBatchEmpty;
+}
+
+int BoardBatch::FindMatches()
+{
+    std::fill(active_.begin(), active_.end(), 1);
+    return FindMatchesActive();
+}
+
+int BoardBatch::FindMatchesActive()
+{
+    if (!Kernels(isa_).find_matches(Data()))
+    {
+        std::fill(active_.begin(), active_.end(), 0);
+        return 0;
+    }
+    int matched = 0;
+    for (size_t block = 0; block < active_.size(); ++block)
+    {
+        if (!active_[block]) continue;
+        const int first = static_cast<int>(block) * kBatchBlock;
+        int hits = 0;
+        for (int lane = first; lane < std::min(first + kBatchBlock, count_); ++lane) hits += cells_[lane] > 0;
+        active_[block] = hits > 0;
+        matched += hits;
+    }
+    return matched;
+}
+
+bool BoardBatch::IsMatched(int lane, const IVec2 & p) const
+{
+    return (matches_[RowAt(p.y, lane)] >> p.x) & 1;
+}
+
+void BoardBatch::CollapseAndRefill()
+{
+    Kernels(isa_).collapse(Data());
+    Refill();
+}
+
+void BoardBatch::CountValidMoves()
+{
+    Kernels(isa_).count_moves(Data());
+}
+
+// After Collapse the holes of each column are its top rows; they refill like
+// Board::CollapseAndRefill does: one batch of draws from the column's stream,
+// the first color going to the lowest hole.
+void BoardBatch::Refill()
+{
+    std::array<int, kMaxSide> holes {};
+    std::array<CellType, kMaxSide> colors {};
+    for (int lane = 0; lane < count_; ++lane)
+    {
+        if (!active_[lane / kBatchBlock]) continue;
+        holes.fill(0);
+        for (int y = 0; y < height_; ++y)
+        {
+            uint16_t & row = matches_[RowAt(y, lane)];
+            for (uint32_t bits = row; bits; bits &= bits - 1) ++holes[std::countr_zero(bits)];
+            row = 0;
+        }
+
+        uint64_t * rng = &rng_[static_cast<size_t>(lane) * (2 + width_)];
+        for (int x = 0; x < width_; ++x)
+        {
+            const int n = holes[x];
+            if (n == 0) continue;
+            CounterRng stream(rng[0], 1 + static_cast<uint64_t>(x));
+            stream.SetPosition(rng[2 + x]);
+            for (int i = 0; i < n; ++i) colors[i] = static_cast<CellType>(UniformBelow(stream, kBatchColors));
+            rng[2 + x] = stream.Position();
+            for (int i = 0; i < n; ++i)
+            {
+                planes_[PlaneAt(static_cast<int>(colors[i]), n - 1 - i, lane)] |= static_cast<uint16_t>(1u << x);
+            }
+        }
+    }
+}
+
+int BoardBatch::Settle(int64_t * scores)
+{
+    int steps = 0;
+    for (int matched = FindMatches(); matched > 0; matched = FindMatchesActive())
+    {
+        for (int lane = 0; lane < count_; ++lane)
+        {
+            scores[lane] += MatchScore(cells_[lane], groups_[lane]);
+        }
+        CollapseAndRefill();
+        ++steps;
+    }
+    return steps;
+}
+
+template void BoardBatch::Load(int, const Board &);
+template void BoardBatch::Load(int, const Board8 &);
+template void BoardBatch::Load(int, const Board9 &);
+template void BoardBatch::Load(int, const DynamicBoard &);
+template void BoardBatch::Store(int, Board &) const;
+template void BoardBatch::Store(int, Board8 &) const;
+template void BoardBatch::Store(int, Board9 &) const;
+template void BoardBatch::Store(int, DynamicBoard &) const;
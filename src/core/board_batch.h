@@ -0,0 +1,140 @@
+#pragma once
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Many boards of one size in structure-of-arrays form, for simulation and
+// search code that evaluates boards in bulk. Each board row is a 16-bit lane
+// (bit x = column x), and lane b of every (plane, row) array belongs to board
+// b, so one SIMD instruction works on 8 (SSE4.1) or 16 (AVX2) boards at once.
+// The kernel set is picked at runtime from what the CPU supports; a portable
+// scalar version is always available.
+//
+// The batch follows the plain rules: FindMatches, CountValidMoves and
+// CollapseAndRefill agree cell for cell with the Board functions of the same
+// name, color bombs included, but no special candies are created or fired.
+// Striped and wrapped candies load as their plain color.
+
+// Planes: one per color, then one for color bombs.
+inline constexpr int kBatchColors = static_cast<int>(CellType::Count);
+inline constexpr int kBatchPlanes = kBatchColors + 1;
+// What BoardBatch::Get reports for a cell without a candy (never loaded, or
+// mid-collapse).
+inline constexpr CellType kBatchEmpty = static_cast<CellType>(kBatchPlanes);
+
+enum class BatchIsa
+{
+    Scalar,
+    Sse4,
+    Avx2
+};
+
+const char * BatchIsaName(BatchIsa isa);
+// Whether this build and CPU can run the given kernels.
+bool BatchIsaSupported(BatchIsa isa);
+
+// Lanes per block: one AVX2 vector. Lane counts are a multiple of it, and the
+// kernels skip whole blocks that are known to be settled.
+inline constexpr int kBatchBlock = 16;
+
+// Raw view handed to the kernels (board_batch_kernels.h). Per-lane arrays hold
+// 'lanes' entries; row arrays hold height * stride, row y of lane b at
+// y * stride + b. The stride is padded past 'lanes' so that a lane's rows do not
+// all fall into one L1 set when 'lanes' is a large power of two.
+struct BatchData
+{
+    int width {0};
+    int height {0};
+    int lanes {0};
+    int stride {0};
+    uint16_t * planes {nullptr};   // kBatchPlanes row arrays
+    uint16_t * matches {nullptr};  // row array
+    uint16_t * cells {nullptr};    // matched cells per lane
+    uint16_t * groups {nullptr};   // match groups per lane
+    uint16_t * moves {nullptr};    // valid swaps per lane
+    uint8_t * active {nullptr};    // per block: 0 = FindMatches and Collapse skip it
+};
+
+class BoardBatch
+{
+public:
+    static constexpr int kMaxSide = 16;
+
+    // Room for 'count' boards of width x height (3..kMaxSide each); every
+    // board starts empty (no candies). Uses the best supported kernels.
+    BoardBatch(int width, int height, int count);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int Count() const { return count_; }
+
+    BatchIsa Isa() const { return isa_; }
+    // Switches kernels; false (and no change) if not supported here.
+    bool SetIsa(BatchIsa isa);
+
+    // Copies a board of the batch size into a lane, cells and refill streams.
+    template <int W, int H>
+    void Load(int lane, const BasicBoard<W, H> & board);
+    // Writes a lane back into a board of the batch size (cells and RNG).
+    template <int W, int H>
+    void Store(int lane, BasicBoard<W, H> & board) const;
+
+    // Cell of a lane, or kBatchEmpty.
+    CellType Get(int lane, const IVec2 & p) const;
+
+    // Board::FindMatches on every lane. Returns the number of lanes with a match.
+    int FindMatches();
+    bool IsMatched(int lane, const IVec2 & p) const;
+    int MatchCells(int lane) const { return cells_[lane]; }
+    int MatchGroups(int lane) const { return groups_[lane]; }
+
+    // Board::CollapseAndRefill of the cells found by the last FindMatches, on
+    // every lane: candies fall and each column refills from its board's own
+    // spawn stream, so a stored-back board matches what the Board would do.
+    void CollapseAndRefill();
+
+    // Board::ValidMoveCount on every lane.
+    void CountValidMoves();
+    int ValidMoveCount(int lane) const { return moves_[lane]; }
+
+    // Matches, collapses and refills until no lane has a match, adding every
+    // step's MatchScore to scores[lane] (Count() entries). Blocks of boards
+    // that have settled drop out of later steps. Returns the number of steps
+    // taken by the longest cascade.
+    int Settle(int64_t * scores);
+
+private:
+    int width_ {0};
+    int height_ {0};
+    int count_ {0};
+    int lanes_ {0};
+    int stride_ {0};
+    BatchIsa isa_ {BatchIsa::Scalar};
+    std::vector<uint16_t> planes_;
+    std::vector<uint16_t> matches_;
+    std::vector<uint16_t> cells_;
+    std::vector<uint16_t> groups_;
+    std::vector<uint16_t> moves_;
+    // Per block: whether the last FindMatches matched anything in it.
+    std::vector<uint8_t> active_;
+    // Per lane: RNG key, stream 0 position, then width_ column stream positions.
+    std::vector<uint64_t> rng_;
+
+    BatchData Data();
+    size_t RowAt(int y, int lane) const { return static_cast<size_t>(y) * stride_ + lane; }
+    size_t PlaneAt(int plane, int y, int lane) const { return static_cast<size_t>(plane) * height_ * stride_ + RowAt(y, lane); }
+    // FindMatches over the active blocks only; blocks without a match go inactive.
+    int FindMatchesActive();
+    void Refill();
+};
+
+extern template void BoardBatch::Load(int, const Board &);
+extern template void BoardBatch::Load(int, const Board8 &);
+extern template void BoardBatch::Load(int, const Board9 &);
+extern template void BoardBatch::Load(int, const DynamicBoard &);
+extern template void BoardBatch::Store(int, Board &) const;
+extern template void BoardBatch::Store(int, Board8 &) const;
+extern template void BoardBatch::Store(int, Board9 &) const;
+extern template void BoardBatch::Store(int, DynamicBoard &) const;
@@ -0,0 +1,42 @@
+// Built with -mavx2 (see CMakeLists.txt); only called after a CPU check.
+#include "board_batch_kernels.h"
+
+#if defined(MATCH3_X86_KERNELS)
+#include <immintrin.h>
+
+namespace
+{
+    // Sixteen boards per vector.
+    struct Avx2Lanes
+    {
+        using T = __m256i;
+        static constexpr int kLanes = 16;
+
+        static T Load(const uint16_t * p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+        static void Store(uint16_t * p, T v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+        static T Zero() { return _mm256_setzero_si256(); }
+        static T Splat(uint16_t v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+        static T And(T a, T b) { return _mm256_and_si256(a, b); }
+        static T Or(T a, T b) { return _mm256_or_si256(a, b); }
+        static T AndNot(T a, T b) { return _mm256_andnot_si256(b, a); }
+        static T Add(T a, T b) { return _mm256_add_epi16(a, b); }
+        template <int K> static T Shl(T v) { return _mm256_slli_epi16(v, K); }
+        template <int K> static T Shr(T v) { return _mm256_srli_epi16(v, K); }
+        static T Popcount(T v)
+        {
+            // Nibble lookup per byte, then the two bytes of each lane summed.
+            const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m256i low = _mm256_set1_epi8(0x0F);
+            const __m256i c8 = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(v, low)),
+                                               _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+            return _mm256_add_epi16(_mm256_and_si256(c8, _mm256_set1_epi16(0x00FF)), _mm256_srli_epi16(c8, 8));
+        }
+        static bool Any(T v) { return !_mm256_testz_si256(v, v); }
+    };
+}
+
+bool BatchFindMatchesAvx2(const BatchData & d) { return batch_kernels::FindMatches<Avx2Lanes>(d); }
+void BatchCountValidMovesAvx2(const BatchData & d) { batch_kernels::CountValidMoves<Avx2Lanes>(d); }
+void BatchCollapseAvx2(const BatchData & d) { batch_kernels::Collapse<Avx2Lanes>(d); }
+#endif
@@ -0,0 +1,205 @@
+#pragma once
+#include "board_batch.h"
+
+#include <cstdint>
+
+// BoardBatch kernels, written once over a lane-vector policy 'V' and
+// instantiated per instruction set (board_batch.cpp, board_batch_sse4.cpp,
+// board_batch_avx2.cpp). Internal to match3_core; each including TU passes
+// its own V from an anonymous namespace, so the instantiations never clash.
+//
+// V provides, for a vector of V::kLanes 16-bit lanes:
+//   T Load(const uint16_t *), void Store(uint16_t *, T), T Zero(), T Splat(uint16_t),
+//   And, Or, AndNot(a, b) = a & ~b, Add, Shl<K>, Shr<K>, Popcount (per lane),
+//   bool Any(T).
+//
+// Every lane is one row of one board: bit x is column x, bits >= width are
+// zero. Rows outside the board read as zero, which is all the edge handling
+// the formulas below need.
+
+// Entry points, one set per instruction set.
+bool BatchFindMatchesScalar(const BatchData & d);
+void BatchCountValidMovesScalar(const BatchData & d);
+void BatchCollapseScalar(const BatchData & d);
+#if defined(MATCH3_X86_KERNELS)
+bool BatchFindMatchesSse4(const BatchData & d);
+void BatchCountValidMovesSse4(const BatchData & d);
+void BatchCollapseSse4(const BatchData & d);
+bool BatchFindMatchesAvx2(const BatchData & d);
+void BatchCountValidMovesAvx2(const BatchData & d);
+void BatchCollapseAvx2(const BatchData & d);
+#endif
+
+namespace batch_kernels
+{
+    template <typename V>
+    typename V::T Row(const uint16_t * plane, int y, int height, int stride, int lane)
+    {
+        return (y >= 0 && y < height) ? V::Load(plane + static_cast<size_t>(y) * stride + lane) : V::Zero();
+    }
+
+    // Board::FindMatches per lane: matches[y] gets the matched cells of row y,
+    // cells/groups the per-board totals. Inactive blocks report no match and
+    // keep their (already clear) matches. Returns true if any lane matched.
+    template <typename V>
+    bool FindMatches(const BatchData & d)
+    {
+        using T = typename V::T;
+        const size_t plane_stride = static_cast<size_t>(d.height) * d.stride;
+        T any = V::Zero();
+
+        for (int lane = 0; lane < d.lanes; lane += V::kLanes)
+        {
+            if (!d.active[lane / kBatchBlock])
+            {
+                V::Store(d.groups + lane, V::Zero());
+                V::Store(d.cells + lane, V::Zero());
+                continue;
+            }
+            T groups = V::Zero();
+            T cells = V::Zero();
+            for (int y = 0; y < d.height; ++y)
+            {
+                T matched = V::Zero();
+                for (int c = 0; c < kBatchColors; ++c)
+                {
+                    const uint16_t * plane = d.planes + c * plane_stride;
+                    const T p = Row<V>(plane, y, d.height, d.stride, lane);
+                    const T up2 = Row<V>(plane, y - 2, d.height, d.stride, lane);
+                    const T up1 = Row<V>(plane, y - 1, d.height, d.stride, lane);
+                    const T dn1 = Row<V>(plane, y + 1, d.height, d.stride, lane);
+                    const T dn2 = Row<V>(plane, y + 2, d.height, d.stride, lane);
+
+                    // Triples starting here, and the cells of every triple through this row.
+                    const T hs = V::And(p, V::And(V::template Shr<1>(p), V::template Shr<2>(p)));
+                    const T vs = V::And(p, V::And(dn1, dn2));
+                    const T hm = V::Or(hs, V::Or(V::template Shl<1>(hs), V::template Shl<2>(hs)));
+                    const T vm = V::Or(vs, V::Or(V::And(up1, V::And(p, dn1)), V::And(up2, V::And(up1, p))));
+                    matched = V::Or(matched, V::Or(hm, vm));
+
+                    // A maximal run starts where a triple starts and the previous cell differs.
+                    const T h_starts = V::AndNot(hs, V::template Shl<1>(p));
+                    const T v_starts = V::AndNot(vs, up1);
+                    groups = V::Add(groups, V::Add(V::Popcount(h_starts), V::Popcount(v_starts)));
+                }
+                V::Store(d.matches + static_cast<size_t>(y) * d.stride + lane, matched);
+                cells = V::Add(cells, V::Popcount(matched));
+            }
+            V::Store(d.groups + lane, groups);
+            V::Store(d.cells + lane, cells);
+            any = V::Or(any, cells);
+        }
+        return V::Any(any);
+    }
+
+    // Board::ValidMoveCount per lane. A swap is valid when a color bomb takes
+    // part or when either candy lands in a triple that does not use the cell
+    // it came from; swapping two candies of one color never is.
+    template <typename V>
+    void CountValidMoves(const BatchData & d)
+    {
+        using T = typename V::T;
+        const size_t plane_stride = static_cast<size_t>(d.height) * d.stride;
+        const T not_last_column = V::Splat(static_cast<uint16_t>((1u << (d.width - 1)) - 1));
+
+        for (int lane = 0; lane < d.lanes; lane += V::kLanes)
+        {
+            T count = V::Zero();
+            for (int y = 0; y < d.height; ++y)
+            {
+                const uint16_t * bombs = d.planes + kBatchColors * plane_stride;
+                const T b0 = Row<V>(bombs, y, d.height, d.stride, lane);
+                const T b1 = Row<V>(bombs, y + 1, d.height, d.stride, lane);
+                T right = V::And(V::Or(b0, V::template Shr<1>(b0)), not_last_column);
+                T down = (y + 1 < d.height) ? V::Or(b0, b1) : V::Zero();
+
+                for (int c = 0; c < kBatchColors; ++c)
+                {
+                    const uint16_t * plane = d.planes + c * plane_stride;
+                    const T p = Row<V>(plane, y, d.height, d.stride, lane);
+                    const T up2 = Row<V>(plane, y - 2, d.height, d.stride, lane);
+                    const T up1 = Row<V>(plane, y - 1, d.height, d.stride, lane);
+                    const T dn1 = Row<V>(plane, y + 1, d.height, d.stride, lane);
+                    const T dn2 = Row<V>(plane, y + 2, d.height, d.stride, lane);
+                    const T dn3 = Row<V>(plane, y + 3, d.height, d.stride, lane);
+
+                    // Vertical pairs that complete a triple at (x, y) without using row y
+                    // itself; horizontal pairs that do so at (x, row) without column x.
+                    const T vpair = V::Or(V::And(up2, up1), V::Or(V::And(up1, dn1), V::And(dn1, dn2)));
+                    auto hpair = [](T r) {
+                        const T l1 = V::template Shl<1>(r);
+                        const T r1 = V::template Shr<1>(r);
+                        return V::Or(V::And(l1, V::template Shl<2>(r)),
+                                     V::Or(V::And(l1, r1), V::And(r1, V::template Shr<2>(r))));
+                    };
+
+                    // Right swap of (x, y): this color moves from x to x + 1, or from x + 1 to x.
+                    const T to_right = V::And(p, V::Or(V::And(V::template Shr<2>(p), V::template Shr<3>(p)),
+                                                       V::template Shr<1>(vpair)));
+                    const T to_left = V::And(V::template Shr<1>(p),
+                                             V::Or(V::And(V::template Shl<1>(p), V::template Shl<2>(p)), vpair));
+                    right = V::Or(right, V::AndNot(V::Or(to_right, to_left), V::And(p, V::template Shr<1>(p))));
+
+                    // Down swap of (x, y) with (x, y + 1).
+                    const T to_down = V::And(p, V::Or(V::And(dn2, dn3), hpair(dn1)));
+                    const T to_up = V::And(dn1, V::Or(V::And(up1, up2), hpair(p)));
+                    down = V::Or(down, V::AndNot(V::Or(to_down, to_up), V::And(p, dn1)));
+                }
+                count = V::Add(count, V::Add(V::Popcount(right), V::Popcount(down)));
+            }
+            V::Store(d.moves + lane, count);
+        }
+    }
+
+    // Removes the cells in d.matches and lets everything above fall, with
+    // bit-parallel gravity: a bottom-up pass drops every candy that has a hole
+    // directly below it, so each stack above a gap moves down one row per
+    // pass, and passes repeat until no lane changes. d.matches is left holding
+    // the holes, which are then the top rows of each column.
+    template <typename V>
+    void Collapse(const BatchData & d)
+    {
+        using T = typename V::T;
+        const size_t plane_stride = static_cast<size_t>(d.height) * d.stride;
+
+        for (int lane = 0; lane < d.lanes; lane += V::kLanes)
+        {
+            if (!d.active[lane / kBatchBlock]) continue;
+            for (int c = 0; c < kBatchPlanes; ++c)
+            {
+                uint16_t * plane = d.planes + c * plane_stride;
+                for (int y = 0; y < d.height; ++y)
+                {
+                    uint16_t * at = plane + static_cast<size_t>(y) * d.stride + lane;
+                    V::Store(at, V::AndNot(V::Load(at), V::Load(d.matches + static_cast<size_t>(y) * d.stride + lane)));
+                }
+            }
+
+            for (int pass = 0; pass < d.height - 1; ++pass)
+            {
+                T moved_any = V::Zero();
+                for (int y = d.height - 2; y >= 0; --y)
+                {
+                    uint16_t * hole_here = d.matches + static_cast<size_t>(y) * d.stride + lane;
+                    uint16_t * hole_below = hole_here + d.stride;
+                    const T here = V::Load(hole_here);
+                    const T below = V::Load(hole_below);
+                    const T fall = V::AndNot(below, here);
+                    if (!V::Any(fall)) continue;
+
+                    moved_any = V::Or(moved_any, fall);
+                    V::Store(hole_below, V::AndNot(below, fall));
+                    V::Store(hole_here, V::Or(here, fall));
+                    for (int c = 0; c < kBatchPlanes; ++c)
+                    {
+                        uint16_t * row = d.planes + c * plane_stride + static_cast<size_t>(y) * d.stride + lane;
+                        const T src = V::Load(row);
+                        V::Store(row + d.stride, V::Or(V::Load(row + d.stride), V::And(src, fall)));
+                        V::Store(row, V::AndNot(src, fall));
+                    }
+                }
+                if (!V::Any(moved_any)) break;
+            }
+        }
+    }
+}
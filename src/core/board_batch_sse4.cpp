@@ -0,0 +1,41 @@
+// Built with -msse4.1 (see CMakeLists.txt); only called after a CPU check.
+#include "board_batch_kernels.h"
+
+#if defined(MATCH3_X86_KERNELS)
+#include <immintrin.h>
+
+namespace
+{
+    // Eight boards per vector.
+    struct Sse4Lanes
+    {
+        using T = __m128i;
+        static constexpr int kLanes = 8;
+
+        static T Load(const uint16_t * p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+        static void Store(uint16_t * p, T v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+        static T Zero() { return _mm_setzero_si128(); }
+        static T Splat(uint16_t v) { return _mm_set1_epi16(static_cast<short>(v)); }
+        static T And(T a, T b) { return _mm_and_si128(a, b); }
+        static T Or(T a, T b) { return _mm_or_si128(a, b); }
+        static T AndNot(T a, T b) { return _mm_andnot_si128(b, a); }
+        static T Add(T a, T b) { return _mm_add_epi16(a, b); }
+        template <int K> static T Shl(T v) { return _mm_slli_epi16(v, K); }
+        template <int K> static T Shr(T v) { return _mm_srli_epi16(v, K); }
+        static T Popcount(T v)
+        {
+            // Nibble lookup per byte, then the two bytes of each lane summed.
+            const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            const __m128i low = _mm_set1_epi8(0x0F);
+            const __m128i c8 = _mm_add_epi8(_mm_shuffle_epi8(lut, _mm_and_si128(v, low)),
+                                            _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), low)));
+            return _mm_add_epi16(_mm_and_si128(c8, _mm_set1_epi16(0x00FF)), _mm_srli_epi16(c8, 8));
+        }
+        static bool Any(T v) { return !_mm_testz_si128(v, v); }
+    };
+}
+
+bool BatchFindMatchesSse4(const BatchData & d) { return batch_kernels::FindMatches<Sse4Lanes>(d); }
+void BatchCountValidMovesSse4(const BatchData & d) { batch_kernels::CountValidMoves<Sse4Lanes>(d); }
+void BatchCollapseSse4(const BatchData & d) { batch_kernels::Collapse<Sse4Lanes>(d); }
+#endif
@@ -0,0 +1,253 @@
+#include "corpus.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    constexpr char kMagic[4] = {'M', '3', 'P', 'C'};
+
+    // Unpacked cells of the record being loaded; LoadCells wants plain arrays.
+    thread_local std::vector<CellType> t_cells;
+    thread_local std::vector<Special> t_specials;
+
+    void StoreLE(uint8_t * p, uint64_t v, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i) p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+
+    void BuildHeader(uint8_t * h, uint8_t flags, int width, int height, size_t record_size,
+                     int64_t count, uint64_t index_offset, int64_t index_count)
+    {
+        std::memset(h, 0, kCorpusHeaderSize);
+        std::memcpy(h, kMagic, 4);
+        h[4] = kCorpusVersion;
+        h[5] = flags;
+        StoreLE(h + 8, static_cast<uint64_t>(width), 2);
+        StoreLE(h + 10, static_cast<uint64_t>(height), 2);
+        StoreLE(h + 12, record_size, 4);
+        StoreLE(h + 16, static_cast<uint64_t>(count), 8);
+        StoreLE(h + 24, index_offset, 8);
+        StoreLE(h + 32, static_cast<uint64_t>(index_count), 8);
+    }
+}
+
+CorpusWriter::~CorpusWriter()
+{
+    if (file_)
+    {
+        std::fclose(file_);
+    }
+}
+
+bool CorpusWriter::Open(const std::string & path, int width, int height, bool specials, bool index)
+{
+    if (file_ || width < 1 || height < 1 || width > kMaxBoardSide || height > kMaxBoardSide)
+    {
+        return false;
+    }
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_)
+    {
+        return false;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, size_t{1} << 20);
+
+    width_ = width;
+    height_ = height;
+    flags_ = static_cast<uint8_t>((specials ? kCorpusHasSpecials : 0) | (index ? kCorpusHasIndex : 0));
+    count_ = 0;
+    index_.clear();
+    record_.assign(CorpusRecordSize(width * height, specials), 0);
+
+    // Placeholder with a record count of 0 until Finish.
+    uint8_t header[kCorpusHeaderSize];
+    BuildHeader(header, flags_, width_, height_, record_.size(), 0, 0, 0);
+    ok_ = std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+    return ok_;
+}
+
+bool CorpusWriter::Add(uint64_t hash, const CellType * cells, const Special * specials, int32_t value)
+{
+    if (!file_ || !ok_)
+    {
+        return false;
+    }
+
+    const int n = width_ * height_;
+    if (!(flags_ & kCorpusHasSpecials) && NeedsSpecialPlane(specials, n))
+    {
+        // Striped and wrapped candies are dropped; hash what is actually stored.
+        for (int i = 0; i < n; ++i)
+        {
+            if (specials[i] != Special::None && specials[i] != Special::ColorBomb)
+            {
+                hash ^= ZobristKey(i, cells[i], specials[i]) ^ ZobristKey(i, cells[i]);
+            }
+        }
+    }
+
+    uint8_t * r = record_.data();
+    StoreLE(r, hash, 8);
+    StoreLE(r + 8, static_cast<uint32_t>(value), 4);
+    PackCells(cells, n, r + kCorpusRecordHeaderSize);
+    if (flags_ & kCorpusHasSpecials)
+    {
+        PackSpecials(specials, n, r + kCorpusRecordHeaderSize + PackedCellBytes(n));
+    }
+    ok_ = std::fwrite(r, 1, record_.size(), file_) == record_.size();
+
+    if (flags_ & kCorpusHasIndex)
+    {
+        index_.emplace_back(hash, static_cast<uint64_t>(count_));
+    }
+    ++count_;
+    return ok_;
+}
+
+bool CorpusWriter::Finish()
+{
+    if (!file_)
+    {
+        return false;
+    }
+
+    const uint64_t index_offset = kCorpusHeaderSize + static_cast<uint64_t>(count_) * record_.size();
+    std::sort(index_.begin(), index_.end());
+    uint8_t entry[16];
+    for (const auto & [hash, record] : index_)
+    {
+        if (!ok_) break;
+        StoreLE(entry, hash, 8);
+        StoreLE(entry + 8, record, 8);
+        ok_ = std::fwrite(entry, 1, sizeof(entry), file_) == sizeof(entry);
+    }
+
+    uint8_t header[kCorpusHeaderSize];
+    BuildHeader(header, flags_, width_, height_, record_.size(), count_,
+                (flags_ & kCorpusHasIndex) ? index_offset : 0, static_cast<int64_t>(index_.size()));
+    ok_ = ok_ && std::fseek(file_, 0, SEEK_SET) == 0 && std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+    ok_ = (std::fclose(file_) == 0) && ok_;
+    file_ = nullptr;
+    index_.clear();
+    index_.shrink_to_fit();
+    return ok_;
+}
+
+Special PositionCorpus::Record::GetSpecial(int index) const
+{
+    if (Cell(index) == CellType::ColorBomb) return Special::ColorBomb;
+    return specials_ ? PackedSpecial(data_ + kCorpusRecordHeaderSize + PackedCellBytes(cells_), index) : Special::None;
+}
+
+void PositionCorpus::Record::Unpack(CellType * cells, Special * specials) const
+{
+    const uint8_t * packed = data_ + kCorpusRecordHeaderSize;
+    UnpackCells(packed, cells_, cells);
+    UnpackSpecials(specials_ ? packed + PackedCellBytes(cells_) : nullptr, cells, cells_, specials);
+}
+
+template <int W, int H>
+void PositionCorpus::Record::Load(BasicBoard<W, H> & board) const
+{
+    t_cells.resize(cells_);
+    t_specials.resize(cells_);
+    Unpack(t_cells.data(), t_specials.data());
+    board.LoadCells(t_cells.data(), t_specials.data());
+}
+
+bool PositionCorpus::Open(const std::string & path, bool sequential)
+{
+    Close();
+    if (!file_.Open(path, sequential))
+    {
+        return false;
+    }
+
+    const uint8_t * h = file_.Data();
+    const size_t size = file_.Size();
+    if (size < kCorpusHeaderSize || std::memcmp(h, kMagic, 4) != 0 || h[4] != kCorpusVersion)
+    {
+        Close();
+        return false;
+    }
+
+    const uint8_t flags = h[5];
+    const int width = h[8] | (h[9] << 8);
+    const int height = h[10] | (h[11] << 8);
+    const size_t record_size = LoadU32LE(h + 12);
+    const uint64_t count = LoadU64LE(h + 16);
+    const uint64_t index_offset = LoadU64LE(h + 24);
+    const uint64_t index_count = LoadU64LE(h + 32);
+
+    // Every section must lie inside the file; overflow-safe since record_size < 2^32.
+    const uint64_t records_space = size - kCorpusHeaderSize;
+    bool ok = width >= 1 && height >= 1 && width <= kMaxBoardSide && height <= kMaxBoardSide &&
+              record_size == CorpusRecordSize(width * height, (flags & kCorpusHasSpecials) != 0) &&
+              count <= records_space / record_size;
+    if (ok && (flags & kCorpusHasIndex))
+    {
+        ok = index_count == count && index_offset == kCorpusHeaderSize + count * record_size &&
+             index_count <= (size - index_offset) / 16;
+    }
+    if (!ok)
+    {
+        Close();
+        return false;
+    }
+
+    width_ = width;
+    height_ = height;
+    flags_ = flags;
+    record_size_ = record_size;
+    count_ = static_cast<int64_t>(count);
+    records_ = h + kCorpusHeaderSize;
+    index_ = (flags & kCorpusHasIndex) ? h + index_offset : nullptr;
+    index_count_ = (flags & kCorpusHasIndex) ? static_cast<int64_t>(index_count) : 0;
+    return true;
+}
+
+void PositionCorpus::Close()
+{
+    file_.Close();
+    records_ = nullptr;
+    index_ = nullptr;
+    width_ = 0;
+    height_ = 0;
+    flags_ = 0;
+    record_size_ = 0;
+    count_ = 0;
+    index_count_ = 0;
+}
+
+int64_t PositionCorpus::Validate() const
+{
+    for (int64_t i = 0; i < count_; ++i)
+    {
+        if (!ValidPackedCells(records_ + static_cast<size_t>(i) * record_size_ + kCorpusRecordHeaderSize, Cells()))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int64_t PositionCorpus::LowerBound(uint64_t hash) const
+{
+    int64_t lo = 0;
+    int64_t hi = index_count_;
+    while (lo < hi)
+    {
+        const int64_t mid = lo + (hi - lo) / 2;
+        if (IndexHash(mid) < hash) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+template void PositionCorpus::Record::Load(Board &) const;
+template void PositionCorpus::Record::Load(Board8 &) const;
+template void PositionCorpus::Record::Load(Board9 &) const;
+template void PositionCorpus::Record::Load(DynamicBoard &) const;
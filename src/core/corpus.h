@@ -0,0 +1,196 @@
+#pragma once
+#include "board.h"
+#include "mapped_file.h"
+#include "position.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Position corpus: a flat file of fixed-size records, one board size per file,
+// meant to be memory-mapped and scanned in place (no parsing, no allocation).
+//
+// Layout (integers little endian, every section 8-byte aligned):
+//
+//   header, kCorpusHeaderSize bytes:
+//     "M3PC"  u8 version  u8 flags  u16 reserved
+//     u16 width  u16 height  u32 record_size
+//     u64 record_count  u64 index_offset  u64 index_count
+//     zero padding
+//   record_count records of record_size bytes (a multiple of 8):
+//     u64 Zobrist hash  i32 value  u32 reserved
+//     PackedCellBytes(cells) bytes of cells
+//     PackedSpecialBytes(cells) bytes of specials, if flags & kCorpusHasSpecials
+//     zero padding
+//   index_count entries, if flags & kCorpusHasIndex, sorted by hash then record:
+//     u64 hash  u64 record
+//
+// 'value' is whatever the dataset labels a position with (score, outcome, ...).
+
+inline constexpr uint8_t kCorpusVersion = 1;
+inline constexpr int kCorpusHeaderSize = 64;
+inline constexpr int kCorpusRecordHeaderSize = 16;
+inline constexpr uint8_t kCorpusHasSpecials = 1;
+inline constexpr uint8_t kCorpusHasIndex = 2;
+
+// Little-endian field loads; compile to single moves on little-endian targets.
+inline uint32_t LoadU32LE(const uint8_t * p)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+inline uint64_t LoadU64LE(const uint8_t * p)
+{
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+constexpr size_t CorpusRecordSize(int cells, bool specials)
+{
+    const size_t raw = kCorpusRecordHeaderSize + PackedCellBytes(cells) + (specials ? PackedSpecialBytes(cells) : 0);
+    return (raw + 7) & ~size_t{7};
+}
+
+// Appends records to a new corpus file. Records stream to disk as they are
+// added; only the index (16 bytes per record) is kept in memory until Finish.
+class CorpusWriter
+{
+public:
+    CorpusWriter() = default;
+    ~CorpusWriter();
+    CorpusWriter(const CorpusWriter &) = delete;
+    CorpusWriter & operator=(const CorpusWriter &) = delete;
+
+    // 'specials' reserves the striped/wrapped plane in every record; without
+    // it such candies are dropped (color bombs are always kept).
+    bool Open(const std::string & path, int width, int height, bool specials, bool index);
+
+    // The board must have the size given to Open.
+    template <int W, int H>
+    bool Add(const BasicBoard<W, H> & board, int32_t value = 0)
+    {
+        return board.Width() == width_ && board.Height() == height_ &&
+               Add(board.Hash(), board.CellData(), board.SpecialData(), value);
+    }
+    // 'hash' is the board's Zobrist hash (adjusted here if specials are dropped).
+    bool Add(uint64_t hash, const CellType * cells, const Special * specials, int32_t value);
+
+    // Writes the index and the final header and closes the file. A corpus
+    // that is never finished has a record count of 0.
+    bool Finish();
+
+    int64_t Count() const { return count_; }
+
+private:
+    FILE * file_ {nullptr};
+    int width_ {0};
+    int height_ {0};
+    uint8_t flags_ {0};
+    bool ok_ {false};
+    int64_t count_ {0};
+    std::vector<uint8_t> record_;
+    std::vector<std::pair<uint64_t, uint64_t>> index_;
+};
+
+// Read-only view of a mapped corpus.
+class PositionCorpus
+{
+public:
+    // A record in place; valid while the corpus stays open.
+    class Record
+    {
+    public:
+        Record(const uint8_t * data, int cells, bool specials) : data_(data), cells_(cells), specials_(specials) {}
+
+        uint64_t Hash() const { return LoadU64LE(data_); }
+        int32_t Value() const { return static_cast<int32_t>(LoadU32LE(data_ + 8)); }
+        CellType Cell(int index) const { return PackedCell(data_ + kCorpusRecordHeaderSize, index); }
+        Special GetSpecial(int index) const;
+
+        // Cells() entries each.
+        void Unpack(CellType * cells, Special * specials) const;
+        // Loads the cells into a board of the corpus size (the RNG is left alone).
+        template <int W, int H>
+        void Load(BasicBoard<W, H> & board) const;
+
+    private:
+        const uint8_t * data_;
+        int cells_;
+        bool specials_;
+    };
+
+    // Maps the file and validates the header and section bounds. Cell codes
+    // are not checked here; Validate does that in one pass.
+    bool Open(const std::string & path, bool sequential = true);
+    void Close();
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    int Cells() const { return width_ * height_; }
+    int64_t Size() const { return count_; }
+    bool HasSpecials() const { return (flags_ & kCorpusHasSpecials) != 0; }
+    bool HasIndex() const { return (flags_ & kCorpusHasIndex) != 0; }
+    size_t RecordSize() const { return record_size_; }
+
+    Record operator[](int64_t i) const
+    {
+        return Record(records_ + static_cast<size_t>(i) * record_size_, Cells(), HasSpecials());
+    }
+
+    template <typename Fn>
+    void ForEach(Fn && fn) const
+    {
+        for (int64_t i = 0; i < count_; ++i) fn((*this)[i]);
+    }
+
+    // Calls fn(record_number) for every record with this hash, through the
+    // index when there is one and a linear scan otherwise. Returns the count.
+    template <typename Fn>
+    int64_t Find(uint64_t hash, Fn && fn) const
+    {
+        int64_t found = 0;
+        if (HasIndex())
+        {
+            for (int64_t i = LowerBound(hash); i < index_count_ && IndexHash(i) == hash; ++i)
+            {
+                const int64_t record = IndexRecord(i);
+                if (record >= 0 && record < count_) { fn(record); ++found; }
+            }
+            return found;
+        }
+        for (int64_t i = 0; i < count_; ++i)
+        {
+            if ((*this)[i].Hash() == hash) { fn(i); ++found; }
+        }
+        return found;
+    }
+
+    // Index of the first record holding an invalid cell code, or -1.
+    int64_t Validate() const;
+
+private:
+    MappedFile file_;
+    const uint8_t * records_ {nullptr};
+    const uint8_t * index_ {nullptr};
+    int width_ {0};
+    int height_ {0};
+    uint8_t flags_ {0};
+    size_t record_size_ {0};
+    int64_t count_ {0};
+    int64_t index_count_ {0};
+
+    int64_t LowerBound(uint64_t hash) const;
+    uint64_t IndexHash(int64_t i) const { return LoadU64LE(index_ + 16 * static_cast<size_t>(i)); }
+    int64_t IndexRecord(int64_t i) const { return static_cast<int64_t>(LoadU64LE(index_ + 16 * static_cast<size_t>(i) + 8)); }
+};
+
+extern template void PositionCorpus::Record::Load(Board &) const;
+extern template void PositionCorpus::Record::Load(Board8 &) const;
+extern template void PositionCorpus::Record::Load(Board9 &) const;
+extern template void PositionCorpus::Record::Load(DynamicBoard &) const;
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory map of a whole file (mmap on POSIX, a file mapping view on
+// Windows). Move-only; the view is released on Close or destruction.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(MappedFile && other) noexcept;
+    MappedFile & operator=(MappedFile && other) noexcept;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    // 'sequential' hints the OS to read ahead aggressively (front-to-back scans).
+    // Fails on a missing or empty file.
+    bool Open(const std::string & path, bool sequential = false);
+    void Close();
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const uint8_t * Data() const { return data_; }
+    size_t Size() const { return size_; }
+
+private:
+    const uint8_t * data_ {nullptr};
+    size_t size_ {0};
+#ifdef _WIN32
+    void * mapping_ {nullptr};
+#endif
+};
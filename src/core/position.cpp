@@ -0,0 +1,164 @@
+#include "position.h"
+
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+    constexpr char kMagic[4] = {'M', '3', 'P', 'S'};
+
+    // Cells and specials of the position being decoded; LoadCells wants plain arrays.
+    thread_local std::vector<CellType> t_cells;
+    thread_local std::vector<Special> t_specials;
+}
+
+void PackCells(const CellType * cells, int count, uint8_t * out)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        uint32_t v = 0;
+        for (int k = 0; k < 8; ++k) v |= static_cast<uint32_t>(cells[i + k]) << (3 * k);
+        out[0] = static_cast<uint8_t>(v);
+        out[1] = static_cast<uint8_t>(v >> 8);
+        out[2] = static_cast<uint8_t>(v >> 16);
+        out += 3;
+    }
+    if (i < count)
+    {
+        uint32_t v = 0;
+        for (int k = 0; i + k < count; ++k) v |= static_cast<uint32_t>(cells[i + k]) << (3 * k);
+        for (int b = 0; b < (3 * (count - i) + 7) / 8; ++b) out[b] = static_cast<uint8_t>(v >> (8 * b));
+    }
+}
+
+void UnpackCells(const uint8_t * packed, int count, CellType * out)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const uint32_t v = packed[0] | (static_cast<uint32_t>(packed[1]) << 8) | (static_cast<uint32_t>(packed[2]) << 16);
+        for (int k = 0; k < 8; ++k) out[i + k] = static_cast<CellType>((v >> (3 * k)) & 7);
+        packed += 3;
+    }
+    for (int k = 0; k < count - i; ++k)
+    {
+        out[i + k] = PackedCell(packed, k);
+    }
+}
+
+void PackSpecials(const Special * specials, int count, uint8_t * out)
+{
+    std::memset(out, 0, PackedSpecialBytes(count));
+    for (int i = 0; i < count; ++i)
+    {
+        const Special s = specials[i];
+        const unsigned v = (s == Special::ColorBomb) ? 0u : static_cast<unsigned>(s);
+        out[i >> 2] = static_cast<uint8_t>(out[i >> 2] | (v << ((i & 3) * 2)));
+    }
+}
+
+void UnpackSpecials(const uint8_t * packed, const CellType * cells, int count, Special * out)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        out[i] = (cells[i] == CellType::ColorBomb) ? Special::ColorBomb
+               : packed                            ? PackedSpecial(packed, i)
+                                                   : Special::None;
+    }
+}
+
+bool NeedsSpecialPlane(const Special * specials, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (specials[i] != Special::None && specials[i] != Special::ColorBomb) return true;
+    }
+    return false;
+}
+
+bool ValidPackedCells(const uint8_t * packed, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (PackedCell(packed, i) > CellType::ColorBomb) return false;
+    }
+    return true;
+}
+
+template <int W, int H>
+void EncodePosition(const BasicBoard<W, H> & board, std::vector<uint8_t> & out)
+{
+    const int cells = board.Cells();
+    const bool specials = NeedsSpecialPlane(board.SpecialData(), cells);
+
+    out.insert(out.end(), std::begin(kMagic), std::end(kMagic));
+    out.push_back(kPositionVersion);
+    out.push_back(specials ? kPositionHasSpecials : 0);
+    out.push_back(static_cast<uint8_t>(board.Width()));
+    out.push_back(static_cast<uint8_t>(board.Width() >> 8));
+    out.push_back(static_cast<uint8_t>(board.Height()));
+    out.push_back(static_cast<uint8_t>(board.Height() >> 8));
+    out.push_back(0); // reserved
+    out.push_back(0);
+
+    const size_t at = out.size();
+    out.resize(at + PackedCellBytes(cells) + (specials ? PackedSpecialBytes(cells) : 0));
+    PackCells(board.CellData(), cells, out.data() + at);
+    if (specials)
+    {
+        PackSpecials(board.SpecialData(), cells, out.data() + at + PackedCellBytes(cells));
+    }
+}
+
+bool PeekPositionSize(const uint8_t * data, size_t size, int & width, int & height)
+{
+    if (size < kPositionHeaderSize || std::memcmp(data, kMagic, 4) != 0 || data[4] != kPositionVersion)
+    {
+        return false;
+    }
+    width = data[6] | (data[7] << 8);
+    height = data[8] | (data[9] << 8);
+    return width >= 1 && height >= 1 && width <= kMaxBoardSide && height <= kMaxBoardSide;
+}
+
+template <int W, int H>
+bool DecodePosition(const uint8_t * data, size_t size, BasicBoard<W, H> & board, size_t * consumed)
+{
+    int width = 0;
+    int height = 0;
+    if (!PeekPositionSize(data, size, width, height) || width != board.Width() || height != board.Height())
+    {
+        return false;
+    }
+
+    const int cells = board.Cells();
+    const bool specials = (data[5] & kPositionHasSpecials) != 0;
+    const size_t total = kPositionHeaderSize + PackedCellBytes(cells) + (specials ? PackedSpecialBytes(cells) : 0);
+    const uint8_t * packed = data + kPositionHeaderSize;
+    if (size < total || !ValidPackedCells(packed, cells))
+    {
+        return false;
+    }
+
+    t_cells.resize(cells);
+    t_specials.resize(cells);
+    UnpackCells(packed, cells, t_cells.data());
+    UnpackSpecials(specials ? packed + PackedCellBytes(cells) : nullptr, t_cells.data(), cells, t_specials.data());
+    board.LoadCells(t_cells.data(), t_specials.data());
+    if (consumed)
+    {
+        *consumed = total;
+    }
+    return true;
+}
+
+template void EncodePosition(const Board &, std::vector<uint8_t> &);
+template void EncodePosition(const Board8 &, std::vector<uint8_t> &);
+template void EncodePosition(const Board9 &, std::vector<uint8_t> &);
+template void EncodePosition(const DynamicBoard &, std::vector<uint8_t> &);
+
+template bool DecodePosition(const uint8_t *, size_t, Board &, size_t *);
+template bool DecodePosition(const uint8_t *, size_t, Board8 &, size_t *);
+template bool DecodePosition(const uint8_t *, size_t, Board9 &, size_t *);
+template bool DecodePosition(const uint8_t *, size_t, DynamicBoard &, size_t *);
@@ -0,0 +1,82 @@
+#pragma once
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Packed positions: 3 bits per cell (the CellType, color bomb included) plus
+// an optional plane of 2 bits per cell for striped and wrapped candies. A
+// color bomb's Special is implied by its cell type, so it needs no plane bit.
+// Both planes pack cells in index order (y * width + x), least significant
+// bit first, 8 cells to every 3 (or 2) bytes, zero-padded to a whole byte.
+//
+// Standalone position layout (integers little endian):
+//
+//   "M3PS"  u8 version  u8 flags  u16 width  u16 height  u16 reserved
+//   PackedCellBytes(width * height) bytes of cells
+//   PackedSpecialBytes(width * height) bytes of specials, if flags & kPositionHasSpecials
+//
+// The RNG is not part of a position: decoding leaves the board's streams alone.
+
+inline constexpr uint8_t kPositionVersion = 1;
+inline constexpr int kPositionHeaderSize = 12;
+inline constexpr uint8_t kPositionHasSpecials = 1;
+
+constexpr size_t PackedCellBytes(int cells) { return (static_cast<size_t>(cells) * 3 + 7) / 8; }
+constexpr size_t PackedSpecialBytes(int cells) { return (static_cast<size_t>(cells) * 2 + 7) / 8; }
+
+void PackCells(const CellType * cells, int count, uint8_t * out);
+void UnpackCells(const uint8_t * packed, int count, CellType * out);
+
+// Only None, StripedH, StripedV and Wrapped are stored; ColorBomb packs as None.
+void PackSpecials(const Special * specials, int count, uint8_t * out);
+// 'packed' may be null (no plane: no striped or wrapped candies). Color bombs
+// are restored from 'cells'.
+void UnpackSpecials(const uint8_t * packed, const CellType * cells, int count, Special * out);
+
+// True if any cell holds a striped or wrapped candy, i.e. the plane is needed.
+bool NeedsSpecialPlane(const Special * specials, int count);
+
+// False if any packed cell is not a valid CellType (only 7 of the 8 codes are).
+bool ValidPackedCells(const uint8_t * packed, int count);
+
+// Reads one cell straight from a packed plane, without unpacking the rest.
+inline CellType PackedCell(const uint8_t * packed, int index)
+{
+    const size_t bit = static_cast<size_t>(index) * 3;
+    const uint8_t * p = packed + (bit >> 3);
+    const unsigned shift = bit & 7;
+    unsigned v = p[0] >> shift;
+    if (shift > 5) v |= static_cast<unsigned>(p[1]) << (8 - shift);
+    return static_cast<CellType>(v & 7);
+}
+
+inline Special PackedSpecial(const uint8_t * packed, int index)
+{
+    return static_cast<Special>((packed[index >> 2] >> ((index & 3) * 2)) & 3);
+}
+
+// Appends the encoded position to out; the specials plane is written only if needed.
+template <int W, int H>
+void EncodePosition(const BasicBoard<W, H> & board, std::vector<uint8_t> & out);
+
+// Board size of the encoded position at the front of [data, data + size).
+// Returns false if it is not a position header.
+bool PeekPositionSize(const uint8_t * data, size_t size, int & width, int & height);
+
+// Loads the position at the front of [data, data + size) into a board of the
+// same size. Returns false (board untouched) on a size mismatch or bad data;
+// on success 'consumed', if given, is the number of bytes used.
+template <int W, int H>
+bool DecodePosition(const uint8_t * data, size_t size, BasicBoard<W, H> & board, size_t * consumed = nullptr);
+
+extern template void EncodePosition(const Board &, std::vector<uint8_t> &);
+extern template void EncodePosition(const Board8 &, std::vector<uint8_t> &);
+extern template void EncodePosition(const Board9 &, std::vector<uint8_t> &);
+extern template void EncodePosition(const DynamicBoard &, std::vector<uint8_t> &);
+
+extern template bool DecodePosition(const uint8_t *, size_t, Board &, size_t *);
+extern template bool DecodePosition(const uint8_t *, size_t, Board8 &, size_t *);
+extern template bool DecodePosition(const uint8_t *, size_t, Board9 &, size_t *);
+extern template bool DecodePosition(const uint8_t *, size_t, DynamicBoard &, size_t *);
@@ -0,0 +1,387 @@
+#include "replay.h"
+#include "rules.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+    constexpr char kMagic[4] = {'M', '3', 'R', 'P'};
+
+    void PutU32(std::vector<uint8_t> & out, uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+
+    void PutVarint(std::vector<uint8_t> & out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(v));
+    }
+
+    // Bounds-checked reader; every Get* fails (and stays failed) past the end.
+    struct Reader
+    {
+        const uint8_t * p;
+        const uint8_t * end;
+        bool ok {true};
+
+        bool Need(size_t n)
+        {
+            if (!ok || static_cast<size_t>(end - p) < n) ok = false;
+            return ok;
+        }
+
+        uint32_t GetU32()
+        {
+            if (!Need(4)) return 0;
+            uint32_t v = 0;
+            for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+            p += 4;
+            return v;
+        }
+
+        uint64_t GetVarint()
+        {
+            uint64_t v = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+                if (!Need(1)) return 0;
+                const uint8_t b = *p++;
+                v |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return v;
+            }
+            ok = false;
+            return 0;
+        }
+
+        // Varint that must fit in [0, limit].
+        int GetInt(uint64_t limit)
+        {
+            const uint64_t v = GetVarint();
+            if (v > limit) ok = false;
+            return ok ? static_cast<int>(v) : 0;
+        }
+
+        // Varint that must fit in an int64_t (scores).
+        int64_t GetInt64()
+        {
+            const uint64_t v = GetVarint();
+            if (v > static_cast<uint64_t>(INT64_MAX)) ok = false;
+            return ok ? static_cast<int64_t>(v) : 0;
+        }
+    };
+
+    constexpr uint64_t kIntLimit = 0x7FFFFFFF;
+}
+
+void EncodeReplay(const Replay & replay, std::vector<uint8_t> & out)
+{
+    const size_t header_at = out.size();
+    out.insert(out.end(), std::begin(kMagic), std::end(kMagic));
+    out.push_back(kReplayVersion);
+    out.push_back(0); // flags
+    out.push_back(0); // reserved
+    out.push_back(0);
+    PutU32(out, 0);   // payload size, patched below
+
+    const size_t payload_at = out.size();
+    PutVarint(out, static_cast<uint64_t>(replay.width));
+    PutVarint(out, static_cast<uint64_t>(replay.height));
+    PutU32(out, replay.seed);
+    PutVarint(out, static_cast<uint64_t>(replay.final_score));
+    PutVarint(out, static_cast<uint64_t>(replay.keyframe_interval));
+
+    PutVarint(out, replay.moves.size());
+    for (const ReplayMove & m : replay.moves)
+    {
+        PutVarint(out, (static_cast<uint64_t>(m.origin) << 1) | (m.down ? 1u : 0u));
+    }
+
+    PutVarint(out, replay.keyframes.size());
+    for (const ReplayKeyframe & k : replay.keyframes)
+    {
+        PutVarint(out, static_cast<uint64_t>(k.move_index));
+        PutVarint(out, static_cast<uint64_t>(k.score));
+        for (size_t i = 0; i < k.cells.size(); ++i)
+        {
+            const uint8_t special = (i < k.specials.size()) ? static_cast<uint8_t>(k.specials[i]) : 0;
+            out.push_back(static_cast<uint8_t>(static_cast<uint8_t>(k.cells[i]) | (special << 4)));
+        }
+        PutVarint(out, k.rng_state.size());
+        out.insert(out.end(), k.rng_state.begin(), k.rng_state.end());
+    }
+
+    const uint32_t payload = static_cast<uint32_t>(out.size() - payload_at);
+    for (int i = 0; i < 4; ++i)
+    {
+        out[header_at + 8 + i] = static_cast<uint8_t>(payload >> (8 * i));
+    }
+}
+
+bool DecodeReplay(const uint8_t * data, size_t size, Replay & out, size_t * consumed)
+{
+    if (size < kReplayHeaderSize || std::memcmp(data, kMagic, 4) != 0 || data[4] != kReplayVersion)
+    {
+        return false;
+    }
+
+    Reader header {data + 8, data + kReplayHeaderSize};
+    const uint32_t payload = header.GetU32();
+    if (size - kReplayHeaderSize < payload)
+    {
+        return false;
+    }
+
+    Reader r {data + kReplayHeaderSize, data + kReplayHeaderSize + payload};
+    Replay rp;
+    rp.width = r.GetInt(kMaxBoardSide);
+    rp.height = r.GetInt(kMaxBoardSide);
+    rp.seed = r.GetU32();
+    rp.final_score = r.GetInt64();
+    rp.keyframe_interval = r.GetInt(kIntLimit);
+    if (!r.ok || rp.width < 3 || rp.height < 3)
+    {
+        return false;
+    }
+
+    const int cells = rp.width * rp.height;
+    // Each move takes at least one byte, so the count cannot exceed the payload.
+    const int move_count = r.GetInt(payload);
+    rp.moves.resize(static_cast<size_t>(move_count));
+    for (ReplayMove & m : rp.moves)
+    {
+        const uint64_t v = r.GetVarint();
+        m.origin = static_cast<int>(v >> 1);
+        m.down = (v & 1) != 0;
+        if (v >> 1 >= static_cast<uint64_t>(cells)) r.ok = false;
+        if (!r.ok) return false;
+    }
+
+    const int keyframe_count = r.GetInt(payload);
+    rp.keyframes.resize(static_cast<size_t>(keyframe_count));
+    int last_index = -1;
+    for (ReplayKeyframe & k : rp.keyframes)
+    {
+        k.move_index = r.GetInt(static_cast<uint64_t>(move_count));
+        k.score = r.GetInt64();
+        if (!r.Need(static_cast<size_t>(cells)) || k.move_index <= last_index) return false;
+        last_index = k.move_index;
+
+        k.cells.resize(static_cast<size_t>(cells));
+        k.specials.resize(static_cast<size_t>(cells));
+        for (int i = 0; i < cells; ++i)
+        {
+            const uint8_t type = r.p[i] & 0x0F;
+            const uint8_t special = r.p[i] >> 4;
+            if (type > static_cast<uint8_t>(CellType::ColorBomb) || special >= static_cast<uint8_t>(Special::Count)) return false;
+            k.cells[i] = static_cast<CellType>(type);
+            k.specials[i] = static_cast<Special>(special);
+        }
+        r.p += cells;
+
+        const size_t rng_len = static_cast<size_t>(r.GetInt(payload));
+        if (!r.Need(rng_len)) return false;
+        k.rng_state.assign(reinterpret_cast<const char *>(r.p), rng_len);
+        r.p += rng_len;
+    }
+
+    if (!r.ok || r.p != r.end)
+    {
+        return false;
+    }
+
+    out = std::move(rp);
+    if (consumed) *consumed = kReplayHeaderSize + payload;
+    return true;
+}
+
+size_t ReplayRecordSize(const uint8_t * header)
+{
+    if (std::memcmp(header, kMagic, 4) != 0)
+    {
+        return 0;
+    }
+    Reader r {header + 8, header + kReplayHeaderSize};
+    return kReplayHeaderSize + static_cast<size_t>(r.GetU32());
+}
+
+bool SaveReplayFile(const std::string & path, const Replay & replay)
+{
+    std::vector<uint8_t> bytes;
+    EncodeReplay(replay, bytes);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+bool LoadReplayFile(const std::string & path, Replay & out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return DecodeReplay(bytes.data(), bytes.size(), out);
+}
+
+void ReplayRecorder::Begin(int width, int height, uint32_t seed, int keyframe_interval)
+{
+    replay_ = Replay {};
+    replay_.width = width;
+    replay_.height = height;
+    replay_.seed = seed;
+    replay_.keyframe_interval = std::max(1, keyframe_interval);
+}
+
+void ReplayRecorder::RecordSwap(const IVec2 & a, const IVec2 & b)
+{
+    const IVec2 & origin = (a.y < b.y || a.x < b.x) ? a : b;
+    ReplayMove m;
+    m.origin = origin.y * replay_.width + origin.x;
+    m.down = (a.y != b.y);
+    replay_.moves.push_back(m);
+}
+
+template <int W, int H>
+void ReplayRecorder::OnSettled(const BasicBoard<W, H> & board, int64_t score)
+{
+    const int n = static_cast<int>(replay_.moves.size());
+    if (n == 0 || n % replay_.keyframe_interval != 0)
+    {
+        return;
+    }
+    if (!replay_.keyframes.empty() && replay_.keyframes.back().move_index == n)
+    {
+        return;
+    }
+
+    ReplayKeyframe k;
+    k.move_index = n;
+    k.score = score;
+    k.cells.assign(board.CellData(), board.CellData() + board.Cells());
+    k.specials.assign(board.SpecialData(), board.SpecialData() + board.Cells());
+    k.rng_state = board.RngState();
+    replay_.keyframes.push_back(std::move(k));
+}
+
+template <int W, int H>
+bool ReplayPlayer::Reset(BasicBoard<W, H> & board)
+{
+    if (board.Width() != replay_->width || board.Height() != replay_->height)
+    {
+        return false;
+    }
+    board.GenerateInitial(replay_->seed);
+    ready_ = board.EnsurePlayable();
+    stuck_ = false;
+    cascade_cut_ = false;
+    position_ = 0;
+    score_ = 0;
+    return ready_;
+}
+
+template <int W, int H>
+bool ReplayPlayer::Step(BasicBoard<W, H> & board)
+{
+    if (position_ >= MoveCount() || stuck_)
+    {
+        return false;
+    }
+
+    const ReplayMove & m = replay_->moves[position_];
+    const IVec2 a {m.origin % replay_->width, m.origin / replay_->width};
+    const IVec2 b = m.down ? IVec2 {a.x, a.y + 1} : IVec2 {a.x + 1, a.y};
+
+    const MoveOutcome out = PlayMove(board, a, b, max_steps_);
+    cascade_cut_ = cascade_cut_ || !out.complete;
+    // The game only reshuffles after a move that changed the board.
+    if (out.valid && !board.EnsurePlayable())
+    {
+        stuck_ = true;
+    }
+    score_ += out.score;
+    ++position_;
+    return true;
+}
+
+template <int W, int H>
+bool ReplayPlayer::Seek(BasicBoard<W, H> & board, int move_index)
+{
+    move_index = std::clamp(move_index, 0, MoveCount());
+
+    const auto & keys = replay_->keyframes;
+    auto it = std::upper_bound(keys.begin(), keys.end(), move_index,
+                               [](int idx, const ReplayKeyframe & k) { return idx < k.move_index; });
+    const ReplayKeyframe * key = (it == keys.begin()) ? nullptr : &*(it - 1);
+
+    // Keep going from the current position when that is closer than any keyframe.
+    const bool forward_ok = ready_ && position_ <= move_index && (!key || key->move_index <= position_);
+    if (!forward_ok)
+    {
+        if (key && static_cast<int>(key->cells.size()) == board.Cells() && key->specials.size() == key->cells.size() &&
+            board.Width() == replay_->width && board.Height() == replay_->height)
+        {
+            board.LoadCells(key->cells.data(), key->specials.data());
+            if (!board.SetRngState(key->rng_state))
+            {
+                ready_ = false;
+                return false;
+            }
+            position_ = key->move_index;
+            score_ = key->score;
+            ready_ = true;
+            stuck_ = !board.HasValidMove();
+        }
+        else if (!Reset(board))
+        {
+            return false;
+        }
+    }
+
+    while (position_ < move_index && Step(board))
+    {
+    }
+    return true;
+}
+
+template <int W, int H>
+bool ReplayPlayer::RunToEnd(BasicBoard<W, H> & board)
+{
+    while (Step(board))
+    {
+    }
+    return score_ == replay_->final_score;
+}
+
+template void ReplayRecorder::OnSettled(const Board &, int64_t);
+template bool ReplayPlayer::Reset(Board &);
+template bool ReplayPlayer::Step(Board &);
+template bool ReplayPlayer::Seek(Board &, int);
+template bool ReplayPlayer::RunToEnd(Board &);
+
+template void ReplayRecorder::OnSettled(const Board8 &, int64_t);
+template bool ReplayPlayer::Reset(Board8 &);
+template bool ReplayPlayer::Step(Board8 &);
+template bool ReplayPlayer::Seek(Board8 &, int);
+template bool ReplayPlayer::RunToEnd(Board8 &);
+
+template void ReplayRecorder::OnSettled(const Board9 &, int64_t);
+template bool ReplayPlayer::Reset(Board9 &);
+template bool ReplayPlayer::Step(Board9 &);
+template bool ReplayPlayer::Seek(Board9 &, int);
+template bool ReplayPlayer::RunToEnd(Board9 &);
+
+template void ReplayRecorder::OnSettled(const DynamicBoard &, int64_t);
+template bool ReplayPlayer::Reset(DynamicBoard &);
+template bool ReplayPlayer::Step(DynamicBoard &);
+template bool ReplayPlayer::Seek(DynamicBoard &, int);
+template bool ReplayPlayer::RunToEnd(DynamicBoard &);
@@ -0,0 +1,170 @@
+#pragma once
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Replays: a game is fully determined by its board size, the seed given to
+// GenerateInitial and the sequence of swaps the player made. Keyframes store
+// the full board (cells + RNG) every few moves so a player can seek without
+// re-simulating from the start.
+//
+// File layout (integers little endian, "varint" = LEB128):
+//
+//   "M3RP"  u8 version  u8 flags  u16 reserved  u32 payload_size
+//   payload:
+//     varint width, varint height, u32 seed, varint final_score
+//     varint keyframe_interval
+//     varint move_count,  move_count  x varint (origin_index << 1 | down)
+//     varint keyframe_count, per keyframe:
+//       varint move_index, varint score,
+//       width * height cell bytes (CellType | Special << 4),
+//       varint rng_len, rng_len bytes of RNG state
+//
+// Every swap is stored by its left/top cell plus a direction bit, so a move
+// costs one byte on boards up to 8x8 and two up to 128x128.
+
+// Bumped whenever the same seed and swaps stop producing the same game
+// (2: Philox RNG, 3: constructive initial boards, 4: special candies,
+// 5: bounded special areas and chains, constructive shuffles); older replays
+// are rejected.
+inline constexpr uint8_t kReplayVersion = 5;
+inline constexpr int kReplayHeaderSize = 12;
+inline constexpr int kDefaultKeyframeInterval = 32;
+
+struct ReplayMove
+{
+    int origin {0};    // y * width + x of the left/top cell
+    bool down {false}; // swap with the lower neighbor instead of the right one
+};
+
+struct ReplayKeyframe
+{
+    int move_index {0}; // number of moves applied before this state
+    int64_t score {0};
+    std::vector<CellType> cells;
+    std::vector<Special> specials; // same size as cells
+    std::string rng_state;
+};
+
+struct Replay
+{
+    int width {0};
+    int height {0};
+    uint32_t seed {0};
+    int64_t final_score {0};
+    int keyframe_interval {kDefaultKeyframeInterval};
+    std::vector<ReplayMove> moves;
+    std::vector<ReplayKeyframe> keyframes; // ascending move_index
+};
+
+// Appends the encoded replay to out.
+void EncodeReplay(const Replay & replay, std::vector<uint8_t> & out);
+
+// Decodes one replay from the front of [data, data + size). On success returns
+// true and, if consumed is given, the number of bytes used (replays can be
+// concatenated into one stream).
+bool DecodeReplay(const uint8_t * data, size_t size, Replay & out, size_t * consumed = nullptr);
+
+// Total encoded size (header included) of the replay whose kReplayHeaderSize
+// header bytes start at 'header', or 0 if they are not a replay header. Lets a
+// reader pull one replay at a time out of a stream; the version is not checked.
+size_t ReplayRecordSize(const uint8_t * header);
+
+bool SaveReplayFile(const std::string & path, const Replay & replay);
+bool LoadReplayFile(const std::string & path, Replay & out);
+
+// Builds a replay while a game is played. Feed it every swap the game accepts
+// and call OnSettled once the board is stable again (after the revert, or
+// after the last cascade and any reshuffle).
+class ReplayRecorder
+{
+public:
+    void Begin(int width, int height, uint32_t seed, int keyframe_interval = kDefaultKeyframeInterval);
+    void RecordSwap(const IVec2 & a, const IVec2 & b);
+
+    template <int W, int H>
+    void OnSettled(const BasicBoard<W, H> & board, int64_t score);
+
+    void Finish(int64_t final_score) { replay_.final_score = final_score; }
+
+    bool Active() const { return replay_.width > 0; }
+    const Replay & Get() const { return replay_; }
+
+private:
+    Replay replay_;
+};
+
+// Re-simulates a replay on a board of matching size, without animations.
+// Moves go through PlayMove plus the game's reshuffle rule, so the board and
+// score follow the recorded game exactly.
+class ReplayPlayer
+{
+public:
+    // max_steps caps the cascade of every move, as in PlayMove.
+    explicit ReplayPlayer(const Replay & replay, int max_steps = kMaxCascadeSteps)
+        : replay_(&replay), max_steps_(max_steps) {}
+
+    // Resets to the initial board. Returns false if the board size does not
+    // match or no playable board could be made from the seed (the game does
+    // not start then). Step needs a Reset or Seek first.
+    template <int W, int H>
+    bool Reset(BasicBoard<W, H> & board);
+
+    // Applies the next move. Returns false at the end of the replay, and once
+    // a deadlocked board could not be reshuffled: every later move would be
+    // reverted, so the score is final (see Stuck).
+    template <int W, int H>
+    bool Step(BasicBoard<W, H> & board);
+
+    // Positions the board after 'move_index' moves by loading the closest
+    // keyframe at or before it and stepping forward from there.
+    template <int W, int H>
+    bool Seek(BasicBoard<W, H> & board, int move_index);
+
+    // Plays every remaining move. Returns true if the final score matches the recording.
+    template <int W, int H>
+    bool RunToEnd(BasicBoard<W, H> & board);
+
+    int Position() const { return position_; }
+    bool Stuck() const { return stuck_; }
+    // True once a move stopped at max_steps with matches left.
+    bool CascadeCut() const { return cascade_cut_; }
+    int64_t Score() const { return score_; }
+    int MoveCount() const { return static_cast<int>(replay_->moves.size()); }
+
+private:
+    const Replay * replay_ {nullptr};
+    int max_steps_ {kMaxCascadeSteps};
+    int position_ {0};
+    int64_t score_ {0};
+    bool ready_ {false}; // board holds the state after position_ moves
+    bool stuck_ {false}; // deadlocked and reshuffling failed
+    bool cascade_cut_ {false};
+};
+
+extern template void ReplayRecorder::OnSettled(const Board &, int64_t);
+extern template bool ReplayPlayer::Reset(Board &);
+extern template bool ReplayPlayer::Step(Board &);
+extern template bool ReplayPlayer::Seek(Board &, int);
+extern template bool ReplayPlayer::RunToEnd(Board &);
+
+extern template void ReplayRecorder::OnSettled(const Board8 &, int64_t);
+extern template bool ReplayPlayer::Reset(Board8 &);
+extern template bool ReplayPlayer::Step(Board8 &);
+extern template bool ReplayPlayer::Seek(Board8 &, int);
+extern template bool ReplayPlayer::RunToEnd(Board8 &);
+
+extern template void ReplayRecorder::OnSettled(const Board9 &, int64_t);
+extern template bool ReplayPlayer::Reset(Board9 &);
+extern template bool ReplayPlayer::Step(Board9 &);
+extern template bool ReplayPlayer::Seek(Board9 &, int);
+extern template bool ReplayPlayer::RunToEnd(Board9 &);
+
+extern template void ReplayRecorder::OnSettled(const DynamicBoard &, int64_t);
+extern template bool ReplayPlayer::Reset(DynamicBoard &);
+extern template bool ReplayPlayer::Step(DynamicBoard &);
+extern template bool ReplayPlayer::Seek(DynamicBoard &, int);
+extern template bool ReplayPlayer::RunToEnd(DynamicBoard &);
@@ -0,0 +1,116 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <limits>
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al., SC'11).
+//
+// Output block n of stream s under key k is a pure function Philox(k, {n, s}),
+// so a generator is just (key, stream, position): copying it is cheap,
+// jumping ahead is an addition, and independent streams (per game, per board
+// column) need no extra state. Only fixed-width integer arithmetic is used, so
+// results are bit-identical on every platform and standard library.
+
+using PhiloxBlock = std::array<uint32_t, 4>;
+
+constexpr PhiloxBlock Philox4x32(PhiloxBlock ctr, uint64_t key)
+{
+    constexpr uint32_t kM0 = 0xD2511F53u;
+    constexpr uint32_t kM1 = 0xCD9E8D57u;
+    constexpr uint32_t kW0 = 0x9E3779B9u;
+    constexpr uint32_t kW1 = 0xBB67AE85u;
+
+    uint32_t k0 = static_cast<uint32_t>(key);
+    uint32_t k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < 10; ++round)
+    {
+        const uint64_t p0 = uint64_t{kM0} * ctr[0];
+        const uint64_t p1 = uint64_t{kM1} * ctr[2];
+        ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ k0, static_cast<uint32_t>(p1),
+               static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ k1, static_cast<uint32_t>(p0)};
+        k0 += kW0;
+        k1 += kW1;
+    }
+    return ctr;
+}
+
+// Word 'index' of stream 'stream' under 'key', without any generator state.
+constexpr uint32_t PhiloxAt(uint64_t key, uint64_t stream, uint64_t index)
+{
+    const uint64_t block = index >> 2;
+    const PhiloxBlock out = Philox4x32({static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+                                        static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32)},
+                                       key);
+    return out[index & 3];
+}
+
+// Sequential view of one Philox stream. Satisfies UniformRandomBitGenerator,
+// but use UniformBelow rather than <random> distributions, whose output is
+// implementation defined.
+class CounterRng
+{
+public:
+    using result_type = uint32_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<uint32_t>::max(); }
+
+    constexpr CounterRng() = default;
+    constexpr explicit CounterRng(uint64_t key, uint64_t stream = 0) : key_(key), stream_(stream) {}
+
+    constexpr void Seed(uint64_t key, uint64_t stream = 0)
+    {
+        key_ = key;
+        stream_ = stream;
+        position_ = 0;
+        // The cached block belongs to the old key and stream.
+        cached_block_ = ~uint64_t{0};
+    }
+
+    constexpr result_type operator()()
+    {
+        const uint64_t block = position_ >> 2;
+        if (block != cached_block_)
+        {
+            cache_ = Philox4x32({static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32),
+                                 static_cast<uint32_t>(stream_), static_cast<uint32_t>(stream_ >> 32)},
+                                key_);
+            cached_block_ = block;
+        }
+        return cache_[position_++ & 3];
+    }
+
+    // Jump ahead by n outputs in O(1).
+    constexpr void Discard(uint64_t n) { position_ += n; }
+
+    constexpr uint64_t Key() const { return key_; }
+    constexpr uint64_t Stream() const { return stream_; }
+    constexpr uint64_t Position() const { return position_; }
+    constexpr void SetPosition(uint64_t position) { position_ = position; }
+
+private:
+    uint64_t key_ {0};
+    uint64_t stream_ {0};
+    uint64_t position_ {0};
+    uint64_t cached_block_ {~uint64_t{0}};
+    PhiloxBlock cache_ {};
+};
+
+// Unbiased integer in [0, n) from a generator returning 32-bit words
+// (Lemire's multiply-shift with rejection). n must be > 0.
+template <typename Gen>
+constexpr uint32_t UniformBelow(Gen && gen, uint32_t n)
+{
+    uint64_t m = uint64_t{gen()} * n;
+    uint32_t low = static_cast<uint32_t>(m);
+    if (low < n)
+    {
+        const uint32_t threshold = (0u - n) % n;
+        while (low < threshold)
+        {
+            m = uint64_t{gen()} * n;
+            low = static_cast<uint32_t>(m);
+        }
+    }
+    return static_cast<uint32_t>(m >> 32);
+}
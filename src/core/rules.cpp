@@ -0,0 +1,22 @@
+#include "rules.h"
+
+template <int W, int H>
+MoveOutcome PlayMove(BasicBoard<W, H> & board, const IVec2 & a, const IVec2 & b, int max_steps)
+{
+    thread_local typename BasicBoard<W, H>::Resolution res;
+
+    MoveOutcome out;
+    board.ApplyMoveAndResolve(a, b, res, max_steps);
+    out.valid = res.valid;
+    out.complete = res.complete;
+    out.score = res.score;
+    out.cascades = res.step_count;
+    out.cleared = res.cleared;
+    out.deadlocked = !board.HasValidMove();
+    return out;
+}
+
+template MoveOutcome PlayMove(Board &, const IVec2 &, const IVec2 &, int);
+template MoveOutcome PlayMove(Board8 &, const IVec2 &, const IVec2 &, int);
+template MoveOutcome PlayMove(Board9 &, const IVec2 &, const IVec2 &, int);
+template MoveOutcome PlayMove(DynamicBoard &, const IVec2 &, const IVec2 &, int);
@@ -0,0 +1,28 @@
+#pragma once
+#include "board.h"
+
+// Game rules shared by the interactive game and the headless tools.
+// PlayMove reproduces exactly what Game::StepStateMachine does to the board
+// for one player swap, minus the animations, so scores and RNG draws match.
+
+struct MoveOutcome
+{
+    bool valid {false};     // false: no match, the swap was reverted
+    bool complete {true};   // false: the cascade hit the step limit
+    int64_t score {0};      // sum over cascade steps of cells * groups
+    int cascades {0};       // number of match/collapse steps (1 = no chain)
+    int cleared {0};        // total cells removed
+    bool deadlocked {false}; // no valid swap left afterwards
+};
+
+// Swap, then resolve matches and cascades until the board is stable or
+// max_steps steps were made (Board::ApplyMoveAndResolve, summarized). Does not
+// reshuffle on deadlock; callers that follow the game rules call
+// EnsurePlayable() afterwards.
+template <int W, int H>
+MoveOutcome PlayMove(BasicBoard<W, H> & board, const IVec2 & a, const IVec2 & b, int max_steps = kMaxCascadeSteps);
+
+extern template MoveOutcome PlayMove(Board &, const IVec2 &, const IVec2 &, int);
+extern template MoveOutcome PlayMove(Board8 &, const IVec2 &, const IVec2 &, int);
+extern template MoveOutcome PlayMove(Board9 &, const IVec2 &, const IVec2 &, int);
+extern template MoveOutcome PlayMove(DynamicBoard &, const IVec2 &, const IVec2 &, int);
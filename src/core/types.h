@@ -0,0 +1,32 @@
+#pragma once
+#include <cstdint>
+
+struct IVec2
+{
+    int x {0};
+    int y {0};
+};
+
+enum class CellType : uint8_t
+{
+    Red = 0,
+    Green,
+    Blue,
+    Yellow,
+    Purple,
+    Orange,
+    Count,              // number of candy colors
+    ColorBomb = Count   // special candy without a color; never part of a run
+};
+
+// Special candy carried by a cell. Striped and wrapped candies keep their
+// color and match like plain ones; a color bomb's CellType is ColorBomb.
+enum class Special : uint8_t
+{
+    None = 0,
+    StripedH,   // clears its row when removed (kSpecialReach to each side)
+    StripedV,   // clears its column when removed (kSpecialReach to each side)
+    Wrapped,    // clears the 3x3 block around it when removed
+    ColorBomb,  // clears the candies of one color (within kSpecialReach)
+    Count
+};
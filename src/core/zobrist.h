@@ -0,0 +1,23 @@
+#pragma once
+#include "types.h"
+
+#include <cstdint>
+
+// Zobrist keys for hashing board contents. Keys are derived on the fly with
+// splitmix64 instead of read from a table, so every board size is covered and
+// nothing has to be initialized. A board hash is the XOR of ZobristKey over
+// all cells.
+
+constexpr uint64_t SplitMix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+constexpr uint64_t ZobristKey(int idx, CellType c, Special s = Special::None)
+{
+    return SplitMix64((static_cast<uint64_t>(idx) << 6) | (static_cast<uint64_t>(s) << 3) |
+                      static_cast<uint64_t>(c));
+}
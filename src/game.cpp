@@ -1,16 +1,17 @@
 #include "game.h"
 
+#include <algorithm>
 #include <chrono>
 #include <optional>
 #include <SDL_ttf.h>
 #include <SDL.h>
 
-static float NowSeconds()
+static double NowSeconds()
 {
     using clock = std::chrono::steady_clock;
     static const auto t0 = clock::now();
     auto dt = clock::now() - t0;
-    return std::chrono::duration<float>(dt).count();
+    return std::chrono::duration<double>(dt).count();
 }
 
 bool Game::Init()
@@ -44,12 +45,27 @@ bool Game::Init()
 
     drawer_ = new Renderer(sdl_renderer_);
 
-    const uint32_t seed = static_cast<uint32_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
-    board_.GenerateInitial(seed);
-
     // Load configuration
     config_.Load("assets/config.yaml");
     hint_delay_ = config_.hint_delay_seconds;
+    t_swap_ = config_.swap_seconds;
+    t_fade_ = config_.fade_seconds;
+    t_drop_ = config_.drop_seconds;
+    t_bump_ = config_.bump_seconds;
+    anims_.SetTimeScale(config_.animation_speed);
+
+    const uint32_t seed = static_cast<uint32_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    board_ = DynamicBoard(config_.board_width, config_.board_height);
+    board_.GenerateInitial(seed);
+    if (!board_.EnsurePlayable())
+    {
+        SDL_Log("No playable %dx%d board", board_.Width(), board_.Height());
+        return false;
+    }
+    if (!config_.replay_path.empty())
+    {
+        recorder_.Begin(board_.Width(), board_.Height(), seed);
+    }
 
     UpdateLayout();
     vboard_.BuildFromBoard(board_, layout_);
@@ -61,7 +77,8 @@ void Game::Run()
 {
     bool quit = false;
 
-    float prev = NowSeconds();
+    const double step = 1.0 / config_.tick_rate_hz;
+    double prev = NowSeconds();
     while (!quit)
     {
         SDL_Event e;
@@ -86,9 +103,10 @@ void Game::Run()
                         if (board_.InBounds(req->a) && board_.InBounds(req->b) && board_.AreAdjacent(req->a, req->b))
                         {
                             board_.Swap(req->a, req->b);
+                            if (recorder_.Active()) recorder_.RecordSwap(req->a, req->b);
                             last_swap_a_ = req->a;
                             last_swap_b_ = req->b;
-                            current_group_ = vboard_.AnimateSwap(req->a, req->b, layout_, anims_, t_swap_);
+                            Await(vboard_.AnimateSwap(req->a, req->b, layout_, anims_, t_swap_));
                             phase_ = Phase::SwapAnim;
                         }
                     }
@@ -110,26 +128,17 @@ void Game::Run()
             }
         }
 
-        float now = NowSeconds();
-        float dt = now - prev;
+        // Simulate in fixed ticks, at most max_catch_up_ticks per frame (a long
+        // stall is dropped rather than replayed), and draw between the last two.
+        const double now = NowSeconds();
+        accumulator_ = std::min(accumulator_ + (now - prev), step * config_.max_catch_up_ticks);
         prev = now;
-        anims_.Update(dt);
-
-        StepStateMachine();
-
-        if (phase_ == Phase::Idle && !anims_.HasActive())
-        {
-            idle_time_ += dt;
-            if (idle_time_ >= hint_delay_ && !hint_swap_)
-            {
-                hint_swap_ = board_.FindAnySwap();
-            }
-        }
-        else
+        while (accumulator_ >= step)
         {
-            idle_time_ = 0.0f;
-            hint_swap_.reset();
+            Tick(static_cast<float>(step));
+            accumulator_ -= step;
         }
+        const float blend = static_cast<float>(accumulator_ / step);
 
         std::optional<IVec2> primary;
         std::optional<IVec2> secondary;
@@ -146,8 +155,9 @@ void Game::Run()
         }
 
         drawer_->DrawBackground(layout_);
-        drawer_->DrawTiles(vboard_.Tiles(), layout_, primary, secondary, now);
+        drawer_->DrawTiles(vboard_.Tiles(), layout_, primary, secondary, static_cast<float>(now), blend);
         drawer_->DrawScore(score_);
+        drawer_->Flush();
         SDL_RenderPresent(sdl_renderer_);
         SDL_Delay(1);
     }
@@ -155,6 +165,15 @@ void Game::Run()
 
 void Game::Shutdown()
 {
+    if (recorder_.Active())
+    {
+        recorder_.Finish(score_);
+        if (!SaveReplayFile(config_.replay_path, recorder_.Get()))
+        {
+            SDL_Log("Failed to write replay to %s", config_.replay_path.c_str());
+        }
+    }
+
     delete drawer_;
     drawer_ = nullptr;
 
@@ -171,13 +190,55 @@ void Game::UpdateLayout()
     if (sdl_renderer_) SDL_GetRendererOutputSize(sdl_renderer_, &w, &h);
     else SDL_GetWindowSize(window_, &w, &h);
 
-    layout_ = drawer_->ComputeLayout(w, h, 6);
+    layout_ = drawer_->ComputeLayout(w, h, board_.Width(), board_.Height(), 6);
+    // About one cell tall; the atlas is only rebuilt when this changes.
+    drawer_->SetTextSize(layout_.cell_size);
 }
 
-void Game::StepStateMachine()
+void Game::Tick(float dt)
 {
-    if (current_group_ != 0 && anims_.IsGroupActive(current_group_)) return;
+    vboard_.Store().SavePrevious();
+    if (config_.instant_animations)
+    {
+        anims_.CompleteAll(vboard_.Store());
+    }
+    else
+    {
+        anims_.Update(dt, vboard_.Store());
+    }
 
+    if (group_done_)
+    {
+        group_done_ = false;
+        StepStateMachine();
+    }
+
+    if (phase_ == Phase::Idle && !anims_.HasActive())
+    {
+        idle_time_ += dt;
+        if (idle_time_ >= hint_delay_ && !hint_swap_)
+        {
+            hint_swap_ = board_.FindAnySwap();
+        }
+    }
+    else
+    {
+        idle_time_ = 0.0f;
+        hint_swap_.reset();
+    }
+}
+
+void Game::Await(uint64_t group)
+{
+    current_group_ = group;
+    group_done_ = false;
+    anims_.OnGroupDone(group, [this, group]() {
+        if (group == current_group_) group_done_ = true;
+    });
+}
+
+void Game::StepStateMachine()
+{
     switch (phase_)
     {
         case Phase::Idle:
@@ -192,22 +253,26 @@ void Game::StepStateMachine()
         {
             int groups = 0;
             int cells = 0;
-            if (!board_.FindMatches(last_mask_, groups, cells))
+            last_created_.clear();
+            if (!board_.ResolveMatches(last_mask_, groups, cells, last_created_, last_swap_a_, last_swap_b_))
             {
                 // Revert swap
                 board_.Swap(last_swap_a_, last_swap_b_);
-                current_group_ = vboard_.AnimateSwap(last_swap_b_, last_swap_a_, layout_, anims_, t_swap_);
+                Await(vboard_.AnimateSwap(last_swap_b_, last_swap_a_, layout_, anims_, t_swap_));
                 phase_ = Phase::Idle;
+                if (recorder_.Active()) recorder_.OnSettled(board_, score_);
             }
             else
             {
-                score_ += cells * groups;
+                score_ += MatchScore(cells, groups);
+                cascade_steps_ = 1;
+                vboard_.ApplyTransforms(last_created_);
                 // Pulse + Fade together in a single group
                 const uint64_t g = anims_.BeginGroup();
                 vboard_.AnimatePulseMask(last_mask_, anims_, t_fade_ * 1.0f, 0.7f, g);
                 vboard_.AnimateFadeMask(last_mask_, anims_, t_fade_, g);
                 anims_.EndGroup();
-                current_group_ = g;
+                Await(g);
                 phase_ = Phase::FadeMatches;
             }
             break;
@@ -221,11 +286,11 @@ void Game::StepStateMachine()
             last_spawns_.clear();
             board_.CollapseAndRefillPlanned(last_mask_, last_moves_, last_spawns_);
 
-            anims_.BeginGroup();
-            vboard_.AnimateMoves(last_moves_, layout_, anims_, t_drop_, anims_.CurrentGroup());
-            vboard_.AnimateSpawns(last_spawns_, layout_, anims_, t_drop_, anims_.CurrentGroup());
+            const uint64_t g = anims_.BeginGroup();
+            vboard_.AnimateMoves(last_moves_, layout_, anims_, t_drop_, g);
+            vboard_.AnimateSpawns(last_spawns_, layout_, anims_, t_drop_, g);
             anims_.EndGroup();
-            current_group_ = anims_.CurrentGroup(); // last BeginGroup id
+            Await(g);
             pending_bump_ = true;
             phase_ = Phase::DropAndSpawn;
             break;
@@ -241,7 +306,7 @@ void Game::StepStateMachine()
                 for (const auto & m : last_moves_) landed.push_back(m.to);
                 for (const auto & s : last_spawns_) landed.push_back(s.to);
 
-                current_group_ = vboard_.AnimateBumpCells(landed, anims_, t_bump_, 1.10f);
+                Await(vboard_.AnimateBumpCells(landed, anims_, t_bump_, 1.10f));
                 pending_bump_ = false;
                 break;
             }
@@ -255,20 +320,33 @@ void Game::StepStateMachine()
         {
             int groups = 0;
             int cells = 0;
-            if (board_.FindMatches(last_mask_, groups, cells))
+            last_created_.clear();
+            if (cascade_steps_ < kMaxCascadeSteps && board_.ResolveMatches(last_mask_, groups, cells, last_created_))
             {
-                score_ += cells * groups;
+                score_ += MatchScore(cells, groups);
+                ++cascade_steps_;
+                vboard_.ApplyTransforms(last_created_);
                 const uint64_t g = anims_.BeginGroup();
                 vboard_.AnimatePulseMask(last_mask_, anims_, t_fade_ * 1.0f, 0.7f, g);
                 vboard_.AnimateFadeMask(last_mask_, anims_, t_fade_, g);
                 anims_.EndGroup();
-                current_group_ = g;
+                Await(g);
                 phase_ = Phase::FadeMatches;
             }
             else
             {
+                // Settled. Reshuffle if no move is left.
+                if (!board_.HasValidMove())
+                {
+                    if (!board_.EnsurePlayable())
+                    {
+                        SDL_Log("Board deadlocked and could not be reshuffled");
+                    }
+                    vboard_.BuildFromBoard(board_, layout_);
+                }
                 phase_ = Phase::Idle;
                 current_group_ = 0;
+                if (recorder_.Active()) recorder_.OnSettled(board_, score_);
             }
             break;
         }
@@ -1,5 +1,7 @@
 #pragma once
 #include "board.h"
+#include "rules.h"
+#include "replay.h"
 #include "renderer.h"
 #include "input.h"
 #include "animation.h"
@@ -21,13 +23,14 @@ private:
     SDL_Window * window_ {nullptr};
     SDL_Renderer * sdl_renderer_ {nullptr};
 
-    Board board_;
+    DynamicBoard board_;
     Renderer * drawer_ {nullptr};
     InputManager input_;
     AnimationSystem anims_;
     VisualBoard vboard_;
 
-    int score_ {0};
+    int64_t score_ {0};
+    ReplayRecorder recorder_;
 
     BoardLayout layout_{};
 
@@ -45,22 +48,34 @@ private:
     IVec2 last_swap_a_ { -1, -1 };
     IVec2 last_swap_b_ { -1, -1 };
     uint64_t current_group_ {0};
-    std::vector<bool> last_mask_;
+    // Match steps of the current move, capped like PlayMove's.
+    int cascade_steps_ {0};
+    // Set when current_group_ drains; the state machine only steps then.
+    bool group_done_ {false};
+    DynamicBoard::Mask last_mask_;
     std::vector<Move> last_moves_;
     std::vector<Spawn> last_spawns_;
+    std::vector<Transform> last_created_;
 
     bool pending_bump_ {false};
 
-    const float t_swap_ = 0.15f;
-    const float t_fade_ = 0.14f;
-    const float t_drop_ = 0.20f;
-    const float t_bump_ = 0.10f;
+    // Tween durations, from Config.
+    float t_swap_ {0.15f};
+    float t_fade_ {0.14f};
+    float t_drop_ {0.20f};
+    float t_bump_ {0.10f};
 
     Config config_{};
     float hint_delay_ {5.0f};
     float idle_time_ {0.0f};
+    // Wall-clock time not yet simulated, below one tick after each frame.
+    double accumulator_ {0.0};
     std::optional<std::pair<IVec2, IVec2>> hint_swap_;
 
     void UpdateLayout();
+    // Makes 'group' the one the state machine waits for.
+    void Await(uint64_t group);
+    // One fixed simulation step: tweens, state machine, idle hint timer.
+    void Tick(float dt);
     void StepStateMachine();
 };
@@ -0,0 +1,81 @@
+#include "geometry_batch.h"
+
+#include <algorithm>
+
+GeometryBatch::GeometryBatch()
+{
+    vertices_.reserve(kReservedQuads * 4);
+    indices_.reserve(kReservedQuads * 6);
+}
+
+void GeometryBatch::AddQuad(float x0, float y0, float x1, float y1, SDL_Color color,
+                            float u0, float v0, float u1, float v1)
+{
+    const int base = static_cast<int>(vertices_.size());
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x0, y0}, color, SDL_FPoint{u0, v0}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x1, y0}, color, SDL_FPoint{u1, v0}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x1, y1}, color, SDL_FPoint{u1, v1}});
+    vertices_.push_back(SDL_Vertex{SDL_FPoint{x0, y1}, color, SDL_FPoint{u0, v1}});
+    for (int i : {0, 1, 2, 0, 2, 3})
+    {
+        indices_.push_back(base + i);
+    }
+}
+
+void GeometryBatch::FillRect(const SDL_Rect & rect, SDL_Color color)
+{
+    if (rect.w <= 0 || rect.h <= 0)
+    {
+        return;
+    }
+    AddQuad(static_cast<float>(rect.x), static_cast<float>(rect.y),
+            static_cast<float>(rect.x + rect.w), static_cast<float>(rect.y + rect.h), color);
+}
+
+void GeometryBatch::OutlineRect(const SDL_Rect & rect, int thickness, SDL_Color color)
+{
+    if (rect.w <= 0 || rect.h <= 0 || thickness <= 0)
+    {
+        return;
+    }
+    // A border that meets itself covers the whole rect.
+    if (thickness * 2 >= std::min(rect.w, rect.h))
+    {
+        FillRect(rect, color);
+        return;
+    }
+
+    const float x0 = static_cast<float>(rect.x);
+    const float y0 = static_cast<float>(rect.y);
+    const float x1 = static_cast<float>(rect.x + rect.w);
+    const float y1 = static_cast<float>(rect.y + rect.h);
+    const float t = static_cast<float>(thickness);
+    AddQuad(x0, y0, x1, y0 + t, color);              // top
+    AddQuad(x0, y1 - t, x1, y1, color);              // bottom
+    AddQuad(x0, y0 + t, x0 + t, y1 - t, color);      // left
+    AddQuad(x1 - t, y0 + t, x1, y1 - t, color);      // right
+}
+
+void GeometryBatch::TexturedRect(const SDL_Rect & dst, const SDL_Rect & src, int texture_w, int texture_h, SDL_Color color)
+{
+    if (dst.w <= 0 || dst.h <= 0 || texture_w <= 0 || texture_h <= 0)
+    {
+        return;
+    }
+    const float sx = 1.0f / static_cast<float>(texture_w);
+    const float sy = 1.0f / static_cast<float>(texture_h);
+    AddQuad(static_cast<float>(dst.x), static_cast<float>(dst.y),
+            static_cast<float>(dst.x + dst.w), static_cast<float>(dst.y + dst.h), color,
+            src.x * sx, src.y * sy, (src.x + src.w) * sx, (src.y + src.h) * sy);
+}
+
+void GeometryBatch::Submit(SDL_Renderer * r, SDL_Texture * texture)
+{
+    if (!Empty())
+    {
+        SDL_RenderGeometry(r, texture, vertices_.data(), static_cast<int>(vertices_.size()),
+                           indices_.data(), static_cast<int>(indices_.size()));
+    }
+    vertices_.clear();
+    indices_.clear();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <SDL.h>
+
+#include <vector>
+
+// Colored quads collected over a frame and drawn with a single
+// SDL_RenderGeometry call, in the order they were added. A batch is either
+// untextured or samples one texture for all its quads (e.g. a glyph atlas).
+// The vertex and index buffers are kept across frames, so a steady frame
+// allocates nothing.
+class GeometryBatch
+{
+public:
+    GeometryBatch();
+
+    // Same pixels as SDL_RenderFillRect; empty rects add nothing.
+    void FillRect(const SDL_Rect & rect, SDL_Color color);
+    // Border 'thickness' pixels wide along the inside of rect (1 is what
+    // SDL_RenderDrawRect draws). Four non-overlapping strips, so translucent
+    // corners are not blended twice.
+    void OutlineRect(const SDL_Rect & rect, int thickness, SDL_Color color);
+    // dst drawn with the texture's src rect (in pixels of a texture_w x
+    // texture_h texture), tinted by color.
+    void TexturedRect(const SDL_Rect & dst, const SDL_Rect & src, int texture_w, int texture_h, SDL_Color color);
+
+    bool Empty() const { return indices_.empty(); }
+    // Draws everything added since the last Submit, then empties the batch.
+    // Untextured quads use the renderer's draw blend mode, textured ones the
+    // texture's.
+    void Submit(SDL_Renderer * r, SDL_Texture * texture = nullptr);
+
+private:
+    // Room for the quads of a large board (fill, outline and marks per tile)
+    // before the buffers have to grow.
+    static constexpr size_t kReservedQuads = 4096;
+
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+
+    // Texture coordinates (u0, v0)..(u1, v1) map onto the corners.
+    void AddQuad(float x0, float y0, float x1, float y1, SDL_Color color,
+                 float u0 = 0.0f, float v0 = 0.0f, float u1 = 0.0f, float v1 = 0.0f);
+};
@@ -0,0 +1,169 @@
+#include "glyph_atlas.h"
+
+#include <SDL_ttf.h>
+#include <algorithm>
+
+namespace
+{
+    // Atlas row width; shrunk to the renderer's limit if that is smaller.
+    constexpr int kAtlasWidth = 2048;
+    // Empty pixels around each glyph, so filtering never samples a neighbor.
+    constexpr int kGlyphPadding = 1;
+
+    // Next code point of UTF-8 text at 'i', advancing i. Malformed bytes
+    // decode as U+FFFD one byte at a time.
+    char32_t NextCodePoint(std::string_view text, size_t & i)
+    {
+        const unsigned char lead = static_cast<unsigned char>(text[i++]);
+        if (lead < 0x80) return lead;
+
+        const int extra = (lead >= 0xF0) ? 3 : (lead >= 0xE0) ? 2 : (lead >= 0xC0) ? 1 : -1;
+        if (extra < 0 || i + extra > text.size()) return 0xFFFD;
+        char32_t c = lead & (0x3F >> extra);
+        for (int k = 0; k < extra; ++k)
+        {
+            const unsigned char b = static_cast<unsigned char>(text[i + k]);
+            if ((b & 0xC0) != 0x80) return 0xFFFD;
+            c = (c << 6) | (b & 0x3F);
+        }
+        i += extra;
+        return c;
+    }
+}
+
+GlyphAtlas::~GlyphAtlas()
+{
+    Reset();
+}
+
+void GlyphAtlas::Reset()
+{
+    if (texture_)
+    {
+        SDL_DestroyTexture(texture_);
+        texture_ = nullptr;
+    }
+    glyphs_.clear();
+    texture_w_ = texture_h_ = 0;
+    point_size_ = line_height_ = 0;
+}
+
+bool GlyphAtlas::Build(SDL_Renderer * r, const char * font_path, int point_size)
+{
+    Reset();
+    ++version_;
+
+    TTF_Font * font = TTF_OpenFont(font_path, point_size);
+    if (!font) return false;
+
+    const int line_height = TTF_FontHeight(font);
+    int width = kAtlasWidth;
+    SDL_RendererInfo info {};
+    if (SDL_GetRendererInfo(r, &info) == 0 && info.max_texture_width > 0)
+    {
+        width = std::min(width, info.max_texture_width);
+    }
+
+    // Render every glyph, then place them in rows of the tallest one.
+    const SDL_Color white {255, 255, 255, 255};
+    std::vector<SDL_Surface *> surfaces;
+    std::vector<Glyph> glyphs;
+    int row_height = line_height;
+    for (char32_t c = kFirst; c <= kLast; ++c)
+    {
+        Glyph g;
+        int minx = 0, maxx = 0, miny = 0, maxy = 0;
+        TTF_GlyphMetrics32(font, c, &minx, &maxx, &miny, &maxy, &g.advance);
+        SDL_Surface * s = TTF_RenderGlyph32_Blended(font, c, white);
+        if (s) row_height = std::max(row_height, s->h);
+        surfaces.push_back(s);
+        glyphs.push_back(g);
+    }
+    TTF_CloseFont(font);
+
+    int x = kGlyphPadding;
+    int y = kGlyphPadding;
+    for (size_t i = 0; i < surfaces.size(); ++i)
+    {
+        const SDL_Surface * s = surfaces[i];
+        if (!s) continue;
+        if (x + s->w + kGlyphPadding > width)
+        {
+            x = kGlyphPadding;
+            y += row_height + kGlyphPadding;
+        }
+        glyphs[i].src = SDL_Rect{x, y, s->w, s->h};
+        x += s->w + kGlyphPadding;
+    }
+
+    const int height = y + row_height + kGlyphPadding;
+    SDL_Surface * atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (atlas)
+    {
+        SDL_FillRect(atlas, nullptr, SDL_MapRGBA(atlas->format, 255, 255, 255, 0));
+        for (size_t i = 0; i < surfaces.size(); ++i)
+        {
+            if (!surfaces[i]) continue;
+            // Copy coverage as is instead of blending it onto the clear pixels.
+            SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+            SDL_Rect dst = glyphs[i].src;
+            SDL_BlitSurface(surfaces[i], nullptr, atlas, &dst);
+        }
+        texture_ = SDL_CreateTextureFromSurface(r, atlas);
+        SDL_FreeSurface(atlas);
+    }
+    for (SDL_Surface * s : surfaces)
+    {
+        if (s) SDL_FreeSurface(s);
+    }
+    if (!texture_) return false;
+
+    SDL_SetTextureBlendMode(texture_, SDL_BLENDMODE_BLEND);
+    glyphs_ = std::move(glyphs);
+    texture_w_ = width;
+    texture_h_ = height;
+    point_size_ = point_size;
+    line_height_ = line_height;
+    return true;
+}
+
+const GlyphAtlas::Glyph & GlyphAtlas::Get(char32_t c) const
+{
+    if (c < kFirst || c > kLast) c = U'?';
+    return glyphs_[c - kFirst];
+}
+
+void TextLayout::Set(const GlyphAtlas & atlas, std::string_view text)
+{
+    if (atlas_version_ == atlas.Version() && text == text_)
+    {
+        return;
+    }
+    text_.assign(text);
+    atlas_version_ = atlas.Version();
+    quads_.clear();
+    width_ = height_ = 0;
+    if (!atlas.Ready()) return;
+
+    int pen_x = 0;
+    int pen_y = 0;
+    for (size_t i = 0; i < text.size();)
+    {
+        const char32_t c = NextCodePoint(text, i);
+        if (c == U'\n')
+        {
+            pen_x = 0;
+            pen_y += atlas.LineHeight();
+            continue;
+        }
+        const GlyphAtlas::Glyph & g = atlas.Get(c);
+        if (g.src.w > 0 && c != U' ')
+        {
+            quads_.push_back(Quad{g.src, SDL_Rect{pen_x, pen_y, g.src.w, g.src.h}});
+            width_ = std::max(width_, pen_x + g.src.w);
+        }
+        pen_x += g.advance;
+        width_ = std::max(width_, pen_x);
+    }
+    height_ = pen_y + atlas.LineHeight();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <SDL.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Printable ASCII rasterized once, at one point size, into a single texture.
+// Text is then drawn as quads sampling it, with no per-frame font rendering
+// or texture upload. Rebuild it when the wanted size changes.
+class GlyphAtlas
+{
+public:
+    struct Glyph
+    {
+        SDL_Rect src {0, 0, 0, 0};   // in the texture; top is the line's top
+        int advance {0};             // pen step to the next glyph
+    };
+
+    GlyphAtlas() = default;
+    ~GlyphAtlas();
+    GlyphAtlas(const GlyphAtlas &) = delete;
+    GlyphAtlas & operator=(const GlyphAtlas &) = delete;
+
+    // Renders the glyphs of the font at 'point_size'; the font is only open
+    // during the build. On failure the atlas is left empty and false returned.
+    bool Build(SDL_Renderer * r, const char * font_path, int point_size);
+    void Reset();
+
+    bool Ready() const { return texture_ != nullptr; }
+    int PointSize() const { return point_size_; }
+    int LineHeight() const { return line_height_; }
+    SDL_Texture * Texture() const { return texture_; }
+    int TextureWidth() const { return texture_w_; }
+    int TextureHeight() const { return texture_h_; }
+    // Bumped by every Build, so a layout can tell that its atlas changed.
+    uint32_t Version() const { return version_; }
+
+    // Characters outside the atlas come out as '?'.
+    const Glyph & Get(char32_t c) const;
+
+private:
+    static constexpr char32_t kFirst = 32;
+    static constexpr char32_t kLast = 126;
+
+    SDL_Texture * texture_ { nullptr };
+    int texture_w_ { 0 };
+    int texture_h_ { 0 };
+    int point_size_ { 0 };
+    int line_height_ { 0 };
+    uint32_t version_ { 0 };
+    std::vector<Glyph> glyphs_;
+};
+
+// A string laid out against a GlyphAtlas: one quad per visible glyph,
+// relative to the text's top-left corner. Set redoes the layout only when the
+// text or the atlas changed, so drawing the same text each frame is free.
+class TextLayout
+{
+public:
+    struct Quad
+    {
+        SDL_Rect src {0, 0, 0, 0};
+        SDL_Rect dst {0, 0, 0, 0};
+    };
+
+    // UTF-8; '\n' starts a new line.
+    void Set(const GlyphAtlas & atlas, std::string_view text);
+
+    int Width() const { return width_; }
+    int Height() const { return height_; }
+    const std::vector<Quad> & Quads() const { return quads_; }
+
+private:
+    std::string text_;
+    uint32_t atlas_version_ { 0 };
+    std::vector<Quad> quads_;
+    int width_ { 0 };
+    int height_ { 0 };
+};
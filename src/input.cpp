@@ -216,7 +216,7 @@ std::optional<IVec2> InputManager::PotentialTargetCell(const BoardLayout & layou
             const IVec2 dir = DirectionFromDelta(dx_px, dy_px);
             const IVec2 b { touch_start_cell_.x + dir.x, touch_start_cell_.y + dir.y };
 
-            if (b.x >= 0 && b.y >= 0 && b.x < Board::kWidth && b.y < Board::kHeight)
+            if (b.x >= 0 && b.y >= 0 && b.x < layout.cols && b.y < layout.rows)
             {
                 return b;
             }
@@ -233,7 +233,7 @@ std::optional<IVec2> InputManager::PotentialTargetCell(const BoardLayout & layou
             const IVec2 dir = DirectionFromDelta(dx, dy);
             const IVec2 b { mouse_start_cell_.x + dir.x, mouse_start_cell_.y + dir.y };
 
-            if (b.x >= 0 && b.y >= 0 && b.x < Board::kWidth && b.y < Board::kHeight)
+            if (b.x >= 0 && b.y >= 0 && b.x < layout.cols && b.y < layout.rows)
             {
                 return b;
             }
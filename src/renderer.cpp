@@ -1,28 +1,49 @@
 #include "renderer.h"
+#include "simd4.h"
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
+#include <iterator>
+
+namespace
+{
+    const char * const kFontPath = "assets/fonts/Inter-Regular.ttf";
+}
 
 Renderer::Renderer(SDL_Renderer * r)
     : r_(r)
 {
-    font_ = TTF_OpenFont("assets/fonts/Inter-Regular.ttf", 150);
 }
 
-Renderer::~Renderer()
+void Renderer::SetTextSize(int point_size)
 {
-    if (font_)
+    if (point_size <= 0 || (atlas_.Ready() && atlas_.PointSize() == point_size))
     {
-        TTF_CloseFont(font_);
-        font_ = nullptr;
+        return;
+    }
+    if (!atlas_.Build(r_, kFontPath, point_size))
+    {
+        SDL_Log("Failed to build glyph atlas from %s at %d pt: %s", kFontPath, point_size, SDL_GetError());
     }
 }
 
-BoardLayout Renderer::ComputeLayout(int window_w, int window_h, int gap_px) const
+void Renderer::LayoutText(TextLayout & text, std::string_view str) const
 {
-    const int cols = Board::kWidth;
-    const int rows = Board::kHeight;
+    text.Set(atlas_, str);
+}
 
+void Renderer::DrawText(const TextLayout & text, int x, int y, SDL_Color color) const
+{
+    for (const TextLayout::Quad & q : text.Quads())
+    {
+        const SDL_Rect dst { x + q.dst.x, y + q.dst.y, q.dst.w, q.dst.h };
+        text_batch_.TexturedRect(dst, q.src, atlas_.TextureWidth(), atlas_.TextureHeight(), color);
+    }
+}
+
+BoardLayout Renderer::ComputeLayout(int window_w, int window_h, int cols, int rows, int gap_px) const
+{
     const int max_board_w = window_w - 20;
     const int max_board_h = window_h - 20;
 
@@ -43,48 +64,87 @@ BoardLayout Renderer::ComputeLayout(int window_w, int window_h, int gap_px) cons
     layout.gap = gap_px;
     layout.width_px = width_px;
     layout.height_px = height_px;
+    layout.cols = cols;
+    layout.rows = rows;
     return layout;
 }
 
-void Renderer::SetColorForCell(CellType type, uint8_t alpha) const
+SDL_Color Renderer::CellColor(CellType type, uint8_t alpha)
 {
-    SDL_SetRenderDrawBlendMode(r_, SDL_BLENDMODE_BLEND);
-
     switch (type)
     {
         case CellType::Red:
         {
-            SDL_SetRenderDrawColor(r_, 230, 68, 68, alpha);
-            break;
+            return SDL_Color{230, 68, 68, alpha};
         }
         case CellType::Green:
         {
-            SDL_SetRenderDrawColor(r_, 80, 200, 120, alpha);
-            break;
+            return SDL_Color{80, 200, 120, alpha};
         }
         case CellType::Blue:
         {
-            SDL_SetRenderDrawColor(r_, 77, 148, 255, alpha);
-            break;
+            return SDL_Color{77, 148, 255, alpha};
         }
         case CellType::Yellow:
         {
-            SDL_SetRenderDrawColor(r_, 245, 211, 66, alpha);
-            break;
+            return SDL_Color{245, 211, 66, alpha};
         }
         case CellType::Purple:
         {
-            SDL_SetRenderDrawColor(r_, 170, 110, 255, alpha);
-            break;
+            return SDL_Color{170, 110, 255, alpha};
         }
         case CellType::Orange:
         {
-            SDL_SetRenderDrawColor(r_, 255, 160, 80, alpha);
+            return SDL_Color{255, 160, 80, alpha};
+        }
+        case CellType::ColorBomb:
+        {
+            return SDL_Color{60, 45, 35, alpha};
+        }
+        default:
+        {
+            return SDL_Color{200, 200, 200, alpha};
+        }
+    }
+}
+
+void Renderer::DrawSpecial(Special special, const SDL_Rect & rect, uint8_t alpha) const
+{
+    const SDL_Color mark {255, 255, 255, static_cast<uint8_t>(alpha * 3 / 4)};
+
+    switch (special)
+    {
+        case Special::StripedH:
+        case Special::StripedV:
+        {
+            // Three stripes along the direction the candy clears.
+            const bool horizontal = (special == Special::StripedH);
+            const int span = horizontal ? rect.h : rect.w;
+            const int thick = std::max(2, span / 10);
+            for (int i = 1; i <= 3; ++i)
+            {
+                const int offset = span * i / 4 - thick / 2;
+                SDL_Rect stripe = horizontal ? SDL_Rect{ rect.x, rect.y + offset, rect.w, thick }
+                                             : SDL_Rect{ rect.x + offset, rect.y, thick, rect.h };
+                batch_.FillRect(stripe, mark);
+            }
+            break;
+        }
+        case Special::Wrapped:
+        {
+            batch_.OutlineRect(rect, std::max(2, rect.w / 8), mark);
+            break;
+        }
+        case Special::ColorBomb:
+        {
+            const int w = rect.w / 3;
+            const int h = rect.h / 3;
+            SDL_Rect core { rect.x + (rect.w - w) / 2, rect.y + (rect.h - h) / 2, w, h };
+            batch_.FillRect(core, mark);
             break;
         }
         default:
         {
-            SDL_SetRenderDrawColor(r_, 200, 200, 200, alpha);
             break;
         }
     }
@@ -92,22 +152,23 @@ void Renderer::SetColorForCell(CellType type, uint8_t alpha) const
 
 void Renderer::DrawBackground(const BoardLayout & layout) const
 {
+    // Anything still batched belongs before the clear.
+    Flush();
     SDL_SetRenderDrawColor(r_, 22, 10, 40, 255);
     SDL_RenderClear(r_);
 
     SDL_Rect bg { layout.origin_x - 8, layout.origin_y - 8, layout.width_px + 16, layout.height_px + 16 };
-    SDL_SetRenderDrawColor(r_, 40, 20, 70, 255);
-    SDL_RenderFillRect(r_, &bg);
+    batch_.FillRect(bg, SDL_Color{40, 20, 70, 255});
 
-    SDL_SetRenderDrawColor(r_, 15, 5, 35, 255);
-    for (int y = 0; y < Board::kHeight; ++y)
+    const SDL_Color line {15, 5, 35, 255};
+    for (int y = 0; y < layout.rows; ++y)
     {
-        for (int x = 0; x < Board::kWidth; ++x)
+        for (int x = 0; x < layout.cols; ++x)
         {
             const int px = layout.origin_x + x * (layout.cell_size + layout.gap);
             const int py = layout.origin_y + y * (layout.cell_size + layout.gap);
             SDL_Rect rect { px, py, layout.cell_size, layout.cell_size };
-            SDL_RenderDrawRect(r_, &rect);
+            batch_.OutlineRect(rect, 1, line);
         }
     }
 }
@@ -117,7 +178,7 @@ void Renderer::DrawHighlightCell(const BoardLayout & layout,
                                  bool is_primary,
                                  float pulse_t) const
 {
-    if (cell.x < 0 || cell.y < 0 || cell.x >= Board::kWidth || cell.y >= Board::kHeight)
+    if (cell.x < 0 || cell.y < 0 || cell.x >= layout.cols || cell.y >= layout.rows)
     {
         return;
     }
@@ -137,58 +198,37 @@ void Renderer::DrawHighlightCell(const BoardLayout & layout,
     SDL_Rect r { cx - w / 2, cy - h / 2, w, h };
 
     // Semi-transparent fill (different tint for primary / secondary).
-    SDL_SetRenderDrawBlendMode(r_, SDL_BLENDMODE_BLEND);
-    if (is_primary)
-    {
-        SDL_SetRenderDrawColor(r_, 255, 255, 255, 60);   // warm
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(r_, 255, 255, 0, 60);   // cool
-    }
-    SDL_RenderFillRect(r_, &r);
+    const uint8_t blue = is_primary ? 255 : 0;   // warm white / cool yellow
+    batch_.FillRect(r, SDL_Color{255, 255, blue, 60});
 
-    // Thick border: 5 px primary, 4 px secondary.
+    // Thick border around the fill: 5 px primary, 4 px secondary.
     const int thick = is_primary ? 5 : 4;
-    if (is_primary)
-    {
-        SDL_SetRenderDrawColor(r_, 255, 255, 255, 200);
-    }
-    else
-    {
-        SDL_SetRenderDrawColor(r_, 255, 255, 0, 200);
-    }
-
-    for (int i = 0; i < thick; ++i)
-    {
-        SDL_Rect outline { r.x - i, r.y - i, r.w + i * 2, r.h + i * 2 };
-        SDL_RenderDrawRect(r_, &outline);
-    }
+    SDL_Rect outline { r.x - (thick - 1), r.y - (thick - 1), r.w + (thick - 1) * 2, r.h + (thick - 1) * 2 };
+    batch_.OutlineRect(outline, thick, SDL_Color{255, 255, blue, 200});
 }
 
-void Renderer::DrawTiles(const std::vector<VisualTile> & tiles,
+void Renderer::DrawTiles(const TileStore & tiles,
                          const BoardLayout & layout,
                          const std::optional<IVec2> & primary,
                          const std::optional<IVec2> & secondary,
-                         float pulse_t) const
+                         float pulse_t,
+                         float blend) const
 {
     // Draw tiles
-    for (const auto & t : tiles)
+    BuildTileRects(tiles, layout, blend);
+    const TileRects & tr = tile_rects_;
+    for (size_t i = 0; i < tiles.Size(); ++i)
     {
-        const float cx = t.x + layout.cell_size * 0.5f;
-        const float cy = t.y + layout.cell_size * 0.5f;
-        const int w = static_cast<int>(layout.cell_size * t.sx);
-        const int h = static_cast<int>(layout.cell_size * t.sy);
-        const int px = static_cast<int>(cx - w * 0.5f);
-        const int py = static_cast<int>(cy - h * 0.5f);
-
-        SDL_Rect rect { px, py, w, h };
-        const uint8_t a = static_cast<uint8_t>(std::clamp(t.alpha, 0.0f, 1.0f) * 255.0f);
-        SetColorForCell(t.type, a);
-        SDL_RenderFillRect(r_, &rect);
-
-        SDL_SetRenderDrawColor(r_, 15, 5, 35, a);
-        SDL_RenderDrawRect(r_, &rect);
+        const TileInfo & t = tiles.Info(i);
+        SDL_Rect rect { tr.x[i], tr.y[i], tr.w[i], tr.h[i] };
+        const uint8_t a = static_cast<uint8_t>(tr.alpha[i]);
+        batch_.FillRect(rect, CellColor(t.type, a));
+        batch_.OutlineRect(rect, 1, SDL_Color{15, 5, 35, a});
+
+        if (t.special != Special::None)
+        {
+            DrawSpecial(t.special, rect, a);
+        }
     }
 
     // Draw highlights on top (avoid double-drawing the same cell).
@@ -206,30 +246,70 @@ void Renderer::DrawTiles(const std::vector<VisualTile> & tiles,
     }
 }
 
-void Renderer::DrawScore(int score) const
+void Renderer::BuildTileRects(const TileStore & tiles, const BoardLayout & layout, float blend) const
 {
-    if (!font_) return;
-
-    const std::string text = "Score: " + std::to_string(score);
-    SDL_Color color{255, 255, 255, 255};
-    SDL_Surface * surf = TTF_RenderUTF8_Blended(font_, text.c_str(), color);
-    if (!surf) return;
-    SDL_Texture * tex = SDL_CreateTextureFromSurface(r_, surf);
-    int w = surf->w;
-    int h = surf->h;
-    SDL_FreeSurface(surf);
-    if (!tex) return;
+    using namespace simd4;
+    const size_t n = Padded(tiles.Size());
+    TileRects & out = tile_rects_;
+    for (auto * column : {&out.x, &out.y, &out.w, &out.h, &out.alpha})
+    {
+        if (column->size() < n) column->resize(n);
+    }
 
-    const int padding = 20;
-    SDL_Rect frame { padding, padding + 150, w + padding * 2, h + padding * 2 };
+    const float * x0 = tiles.Previous(TweenProp::X);
+    const float * x1 = tiles.Current(TweenProp::X);
+    const float * y0 = tiles.Previous(TweenProp::Y);
+    const float * y1 = tiles.Current(TweenProp::Y);
+    const float * a0 = tiles.Previous(TweenProp::Alpha);
+    const float * a1 = tiles.Current(TweenProp::Alpha);
+    const float * sx0 = tiles.Previous(TweenProp::ScaleX);
+    const float * sx1 = tiles.Current(TweenProp::ScaleX);
+    const float * sy0 = tiles.Previous(TweenProp::ScaleY);
+    const float * sy1 = tiles.Current(TweenProp::ScaleY);
+
+    const F4 t = Splat(blend);
+    const F4 size = Splat(static_cast<float>(layout.cell_size));
+    const F4 half_size = Splat(layout.cell_size * 0.5f);
+    const F4 half = Splat(0.5f);
+    const F4 zero = Splat(0.0f);
+    const F4 one = Splat(1.0f);
+    const F4 full = Splat(255.0f);
+    for (size_t i = 0; i < n; i += kLanes)
+    {
+        // The rect keeps the tile's center and scales around it; the width is
+        // rounded before centering so opposite edges move together.
+        const I4 w = ToInt(size * Lerp(Load(sx0 + i), Load(sx1 + i), t));
+        const I4 h = ToInt(size * Lerp(Load(sy0 + i), Load(sy1 + i), t));
+        const F4 cx = Lerp(Load(x0 + i), Load(x1 + i), t) + half_size;
+        const F4 cy = Lerp(Load(y0 + i), Load(y1 + i), t) + half_size;
+        Store(&out.x[i], ToInt(cx - ToFloat(w) * half));
+        Store(&out.y[i], ToInt(cy - ToFloat(h) * half));
+        Store(&out.w[i], w);
+        Store(&out.h[i], h);
+        const F4 a = Min(one, Max(zero, Lerp(Load(a0 + i), Load(a1 + i), t)));
+        Store(&out.alpha[i], ToInt(a * full));
+    }
+}
+
+void Renderer::Flush() const
+{
     SDL_SetRenderDrawBlendMode(r_, SDL_BLENDMODE_BLEND);
-    SDL_SetRenderDrawColor(r_, 0, 0, 0, 150);
-    SDL_RenderFillRect(r_, &frame);
-    SDL_SetRenderDrawColor(r_, 255, 255, 255, 255);
-    SDL_RenderDrawRect(r_, &frame);
+    batch_.Submit(r_);
+    text_batch_.Submit(r_, atlas_.Texture());
+}
+
+void Renderer::DrawScore(int64_t score) const
+{
+    if (!atlas_.Ready()) return;
 
-    SDL_Rect dst { frame.x + padding, frame.y + padding, w, h };
-    SDL_RenderCopy(r_, tex, nullptr, &dst);
+    // Formatted on the stack; the layout is only redone when the digits change.
+    char buf[32] = "Score: ";
+    const char * end = std::to_chars(buf + 7, std::end(buf), score).ptr;
+    LayoutText(score_text_, std::string_view(buf, static_cast<size_t>(end - buf)));
 
-    SDL_DestroyTexture(tex);
+    const int padding = 20;
+    SDL_Rect frame { padding, padding + 150, score_text_.Width() + padding * 2, score_text_.Height() + padding * 2 };
+    batch_.FillRect(frame, SDL_Color{0, 0, 0, 150});
+    batch_.OutlineRect(frame, 1, SDL_Color{255, 255, 255, 255});
+    DrawText(score_text_, frame.x + padding, frame.y + padding, SDL_Color{255, 255, 255, 255});
 }
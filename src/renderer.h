@@ -1,12 +1,13 @@
 #pragma once
 #include "board.h"
+#include "geometry_batch.h"
+#include "glyph_atlas.h"
 #include "visuals.h"
 
 #include <SDL.h>
-#include <SDL_ttf.h>
 #include <vector>
 #include <optional>
-#include <string>
+#include <string_view>
 
 struct BoardLayout
 {
@@ -16,34 +17,72 @@ struct BoardLayout
     int gap { 2 };
     int width_px { 0 };
     int height_px { 0 };
+    int cols { 0 };
+    int rows { 0 };
 };
 
 class Renderer
 {
 public:
     explicit Renderer(SDL_Renderer * r);
-    ~Renderer();
 
-    BoardLayout ComputeLayout(int window_w, int window_h, int gap_px = 4) const;
+    BoardLayout ComputeLayout(int window_w, int window_h, int cols, int rows, int gap_px = 4) const;
 
     void DrawBackground(const BoardLayout & layout) const;
 
     // Draw tiles and optional highlights:
     //  - primary: currently pressed cell
     //  - secondary: intended swap neighbor
-    void DrawTiles(const std::vector<VisualTile> & tiles,
+    // Tiles are drawn 'blend' of the way from their previous-tick state to
+    // their current one (0..1, see Game::Run).
+    void DrawTiles(const TileStore & tiles,
                    const BoardLayout & layout,
                    const std::optional<IVec2> & primary = std::nullopt,
                    const std::optional<IVec2> & secondary = std::nullopt,
-                   float pulse_t = 0.0f) const;
+                   float pulse_t = 0.0f,
+                   float blend = 1.0f) const;
 
-    void DrawScore(int score) const;
+    void DrawScore(int64_t score) const;
+
+    // Rebuilds the glyph atlas if the size changed; until the first call no
+    // text is drawn. Game sizes it to the layout's cells (output pixels).
+    void SetTextSize(int point_size);
+
+    // Text from the glyph atlas: LayoutText updates 'text' (a no-op when the
+    // string and atlas are unchanged), DrawText queues its quads with the
+    // top-left at (x, y). Text is drawn over all shapes of the same Flush.
+    void LayoutText(TextLayout & text, std::string_view str) const;
+    void DrawText(const TextLayout & text, int x, int y, SDL_Color color) const;
+
+    // The Draw* calls batch their shapes; this draws what is pending in one
+    // call. Needed before SDL_RenderPresent.
+    void Flush() const;
 
 private:
     SDL_Renderer * r_ { nullptr };
-    TTF_Font * font_ { nullptr };
+    GlyphAtlas atlas_;
+    mutable TextLayout score_text_;
+
+    // Screen rects and alpha of every tile for the frame being drawn, one
+    // column per field (see BuildTileRects); reused across frames.
+    struct TileRects
+    {
+        std::vector<int32_t> x, y, w, h, alpha;
+    };
+    mutable TileRects tile_rects_;
+
+    // Blends each tile between ticks and computes its scaled, centered rect,
+    // four tiles at a time.
+    void BuildTileRects(const TileStore & tiles, const BoardLayout & layout, float blend) const;
+
+    // Shapes for the next Flush, in draw order, then the text on top.
+    mutable GeometryBatch batch_;
+    mutable GeometryBatch text_batch_;
+
+    static SDL_Color CellColor(CellType type, uint8_t alpha);
 
-    void SetColorForCell(CellType type, uint8_t alpha) const;
+    // Marks drawn over a tile's fill: stripes, a wrapped border or a bomb core.
+    void DrawSpecial(Special special, const SDL_Rect & rect, uint8_t alpha) const;
 
     void DrawHighlightCell(const BoardLayout & layout,
                            const IVec2 & cell,
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Four-lane float/int vectors for the per-frame tile and tween loops. SSE2 on
+// x86-64 and NEON on arm64 are part of the base ISA, so there is no runtime
+// dispatch; other targets get a plain loop with the same results.
+// Loads and stores are unaligned.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATCH3_SIMD4_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define MATCH3_SIMD4_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace simd4
+{
+    constexpr int kLanes = 4;
+
+    // Rounds n up to whole vectors.
+    constexpr size_t Padded(size_t n) { return (n + kLanes - 1) / kLanes * kLanes; }
+
+#if defined(MATCH3_SIMD4_SSE2)
+    struct F4 { __m128 v; };
+    struct I4 { __m128i v; };
+    // All-ones or all-zeros per lane.
+    struct M4 { __m128 v; };
+
+    inline F4 Load(const float * p) { return {_mm_loadu_ps(p)}; }
+    inline void Store(float * p, F4 a) { _mm_storeu_ps(p, a.v); }
+    inline void Store(int32_t * p, I4 a) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), a.v); }
+    inline F4 Splat(float s) { return {_mm_set1_ps(s)}; }
+
+    inline F4 operator+(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+    inline F4 operator-(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+    inline F4 operator*(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+    inline F4 Min(F4 a, F4 b) { return {_mm_min_ps(a.v, b.v)}; }
+    inline F4 Max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+
+    inline M4 operator<=(F4 a, F4 b) { return {_mm_cmple_ps(a.v, b.v)}; }
+    inline M4 operator>=(F4 a, F4 b) { return {_mm_cmpge_ps(a.v, b.v)}; }
+    inline M4 operator|(M4 a, M4 b) { return {_mm_or_ps(a.v, b.v)}; }
+    // m ? a : b per lane.
+    inline F4 Select(M4 m, F4 a, F4 b) { return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))}; }
+
+    // Truncates toward zero, like static_cast<int>.
+    inline I4 ToInt(F4 a) { return {_mm_cvttps_epi32(a.v)}; }
+    inline F4 ToFloat(I4 a) { return {_mm_cvtepi32_ps(a.v)}; }
+#elif defined(MATCH3_SIMD4_NEON)
+    struct F4 { float32x4_t v; };
+    struct I4 { int32x4_t v; };
+    struct M4 { uint32x4_t v; };
+
+    inline F4 Load(const float * p) { return {vld1q_f32(p)}; }
+    inline void Store(float * p, F4 a) { vst1q_f32(p, a.v); }
+    inline void Store(int32_t * p, I4 a) { vst1q_s32(p, a.v); }
+    inline F4 Splat(float s) { return {vdupq_n_f32(s)}; }
+
+    inline F4 operator+(F4 a, F4 b) { return {vaddq_f32(a.v, b.v)}; }
+    inline F4 operator-(F4 a, F4 b) { return {vsubq_f32(a.v, b.v)}; }
+    inline F4 operator*(F4 a, F4 b) { return {vmulq_f32(a.v, b.v)}; }
+    inline F4 Min(F4 a, F4 b) { return {vminq_f32(a.v, b.v)}; }
+    inline F4 Max(F4 a, F4 b) { return {vmaxq_f32(a.v, b.v)}; }
+
+    inline M4 operator<=(F4 a, F4 b) { return {vcleq_f32(a.v, b.v)}; }
+    inline M4 operator>=(F4 a, F4 b) { return {vcgeq_f32(a.v, b.v)}; }
+    inline M4 operator|(M4 a, M4 b) { return {vorrq_u32(a.v, b.v)}; }
+    inline F4 Select(M4 m, F4 a, F4 b) { return {vbslq_f32(m.v, a.v, b.v)}; }
+
+    inline I4 ToInt(F4 a) { return {vcvtq_s32_f32(a.v)}; }
+    inline F4 ToFloat(I4 a) { return {vcvtq_f32_s32(a.v)}; }
+#else
+    struct F4 { float v[kLanes]; };
+    struct I4 { int32_t v[kLanes]; };
+    struct M4 { bool v[kLanes]; };
+
+    template <typename R, typename Fn>
+    inline R Map(Fn fn)
+    {
+        R r {};
+        for (int i = 0; i < kLanes; ++i) r.v[i] = fn(i);
+        return r;
+    }
+
+    inline F4 Load(const float * p) { return Map<F4>([&](int i) { return p[i]; }); }
+    inline void Store(float * p, F4 a) { for (int i = 0; i < kLanes; ++i) p[i] = a.v[i]; }
+    inline void Store(int32_t * p, I4 a) { for (int i = 0; i < kLanes; ++i) p[i] = a.v[i]; }
+    inline F4 Splat(float s) { return Map<F4>([&](int) { return s; }); }
+
+    inline F4 operator+(F4 a, F4 b) { return Map<F4>([&](int i) { return a.v[i] + b.v[i]; }); }
+    inline F4 operator-(F4 a, F4 b) { return Map<F4>([&](int i) { return a.v[i] - b.v[i]; }); }
+    inline F4 operator*(F4 a, F4 b) { return Map<F4>([&](int i) { return a.v[i] * b.v[i]; }); }
+    inline F4 Min(F4 a, F4 b) { return Map<F4>([&](int i) { return a.v[i] < b.v[i] ? a.v[i] : b.v[i]; }); }
+    inline F4 Max(F4 a, F4 b) { return Map<F4>([&](int i) { return a.v[i] > b.v[i] ? a.v[i] : b.v[i]; }); }
+
+    inline M4 operator<=(F4 a, F4 b) { return Map<M4>([&](int i) { return a.v[i] <= b.v[i]; }); }
+    inline M4 operator>=(F4 a, F4 b) { return Map<M4>([&](int i) { return a.v[i] >= b.v[i]; }); }
+    inline M4 operator|(M4 a, M4 b) { return Map<M4>([&](int i) { return a.v[i] || b.v[i]; }); }
+    inline F4 Select(M4 m, F4 a, F4 b) { return Map<F4>([&](int i) { return m.v[i] ? a.v[i] : b.v[i]; }); }
+
+    inline I4 ToInt(F4 a) { return Map<I4>([&](int i) { return static_cast<int32_t>(a.v[i]); }); }
+    inline F4 ToFloat(I4 a) { return Map<F4>([&](int i) { return static_cast<float>(a.v[i]); }); }
+#endif
+
+    // a + (b - a) * t, as Lerp.
+    inline F4 Lerp(F4 a, F4 b, F4 t) { return a + (b - a) * t; }
+}
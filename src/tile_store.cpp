@@ -0,0 +1,98 @@
+#include "tile_store.h"
+#include "simd4.h"
+
+#include <algorithm>
+
+TileHandle TileStore::Insert(const VisualTile & tile)
+{
+    uint32_t slot = 0;
+    if (!free_.empty())
+    {
+        slot = free_.back();
+        free_.pop_back();
+    }
+    else
+    {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(Slot{});
+    }
+
+    const size_t i = info_.size();
+    Slot & s = slots_[slot];
+    s.dense = static_cast<uint32_t>(i);
+    ++s.generation;
+    info_.push_back(tile.info);
+    dense_slot_.push_back(slot);
+
+    if (i >= current_[0].size())
+    {
+        for (size_t p = 0; p < kTweenProps; ++p)
+        {
+            current_[p].resize(simd4::Padded(i + 1));
+            previous_[p].resize(simd4::Padded(i + 1));
+        }
+    }
+    const float values[kTweenProps] = {tile.x, tile.y, tile.alpha, tile.sx, tile.sy};
+    for (size_t p = 0; p < kTweenProps; ++p)
+    {
+        current_[p][i] = previous_[p][i] = values[p];
+    }
+    return {slot, s.generation};
+}
+
+bool TileStore::Remove(TileHandle handle)
+{
+    const uint32_t hole = Find(handle);
+    if (hole == kNoTile)
+    {
+        return false;
+    }
+
+    const uint32_t last = static_cast<uint32_t>(info_.size() - 1);
+    if (hole != last)
+    {
+        info_[hole] = info_[last];
+        for (size_t p = 0; p < kTweenProps; ++p)
+        {
+            current_[p][hole] = current_[p][last];
+            previous_[p][hole] = previous_[p][last];
+        }
+        dense_slot_[hole] = dense_slot_[last];
+        slots_[dense_slot_[hole]].dense = hole;
+    }
+    info_.pop_back();
+    dense_slot_.pop_back();
+
+    ++slots_[handle.slot].generation;
+    free_.push_back(handle.slot);
+    return true;
+}
+
+void TileStore::Clear()
+{
+    for (uint32_t slot : dense_slot_)
+    {
+        ++slots_[slot].generation;
+        free_.push_back(slot);
+    }
+    info_.clear();
+    dense_slot_.clear();
+}
+
+void TileStore::SavePrevious()
+{
+    for (size_t p = 0; p < kTweenProps; ++p)
+    {
+        std::copy_n(current_[p].begin(), info_.size(), previous_[p].begin());
+    }
+}
+
+uint32_t TileStore::Find(TileHandle handle) const
+{
+    if (handle.slot >= slots_.size())
+    {
+        return kNoTile;
+    }
+    const Slot & s = slots_[handle.slot];
+    return (s.generation == handle.generation && (s.generation & 1u)) ? s.dense : kNoTile;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The animated fields of a visual tile; each is one float column in TileStore.
+enum class TweenProp : uint8_t
+{
+    X,          // top-left pixel position
+    Y,
+    Alpha,      // 0..1
+    ScaleX,
+    ScaleY,
+    Count
+};
+
+constexpr size_t kTweenProps = static_cast<size_t>(TweenProp::Count);
+
+// What the animated fields do not cover; read per tile, not per frame.
+struct TileInfo
+{
+    CellType type {CellType::Red};
+    Special special {Special::None};
+    IVec2 cell {0, 0};    // current target cell
+};
+
+// A tile as inserted into a TileStore.
+struct VisualTile
+{
+    TileInfo info;
+    float x {0.0f};
+    float y {0.0f};
+    float alpha {1.0f};
+    float sx {1.0f};
+    float sy {1.0f};
+};
+
+// Names a tile in a TileStore. The generation changes whenever the slot is
+// freed, so a handle to a removed tile never reaches the tile that reuses it.
+struct TileHandle
+{
+    uint32_t slot {0};
+    uint32_t generation {0};
+};
+
+// Slot map of visual tiles: handles stay valid across inserts and removals of
+// other tiles, both O(1), and the tiles themselves are kept dense.
+// Removal moves the last tile into the hole, so dense order is not stable.
+// Storage is a structure of arrays: each animated field is a float column,
+// current and as of the previous simulation tick, padded to whole simd4
+// vectors so tween and draw loops run four tiles at a time.
+class TileStore
+{
+public:
+    static constexpr uint32_t kNoTile = ~0u;
+
+    // The new tile starts with no motion to interpolate (previous = current).
+    TileHandle Insert(const VisualTile & tile);
+    // False if the handle is stale (already removed).
+    bool Remove(TileHandle handle);
+    void Clear();
+    // Copies every current column to the previous one, at the start of a
+    // simulation tick; drawing blends from those to the current values.
+    void SavePrevious();
+
+    // Dense index of the tile, or kNoTile if the handle is stale.
+    uint32_t Find(TileHandle handle) const;
+
+    size_t Size() const { return info_.size(); }
+    TileInfo & Info(size_t i) { return info_[i]; }
+    const TileInfo & Info(size_t i) const { return info_[i]; }
+    // Columns of Size() values, readable up to simd4::Padded(Size()).
+    float * Current(TweenProp p) { return current_[static_cast<size_t>(p)].data(); }
+    const float * Current(TweenProp p) const { return current_[static_cast<size_t>(p)].data(); }
+    const float * Previous(TweenProp p) const { return previous_[static_cast<size_t>(p)].data(); }
+    // Handle of the tile at dense index i.
+    TileHandle HandleAt(size_t i) const { return {dense_slot_[i], slots_[dense_slot_[i]].generation}; }
+
+private:
+    struct Slot
+    {
+        uint32_t dense {0};
+        // Odd while the slot holds a tile, even while it is free.
+        uint32_t generation {0};
+    };
+
+    std::vector<TileInfo> info_;
+    std::array<std::vector<float>, kTweenProps> current_;
+    std::array<std::vector<float>, kTweenProps> previous_;
+    std::vector<uint32_t> dense_slot_;   // slot of each dense tile
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> free_;
+};
@@ -14,57 +14,70 @@ SDL_Rect VisualBoard::CellRect(const IVec2 & c, const BoardLayout & layout)
     return r;
 }
 
-void VisualBoard::BuildFromBoard(const Board & board, const BoardLayout & layout)
+TileHandle VisualBoard::FindTile(const IVec2 & c) const
 {
-    tiles_.clear();
-    tiles_.reserve(Board::kWidth * Board::kHeight);
+    if (c.x < 0 || c.y < 0 || c.x >= width_ || c.y >= height_) return {};
+    return grid_[c.y * width_ + c.x];
+}
+
+void VisualBoard::BuildFromBoard(const DynamicBoard & board, const BoardLayout & layout)
+{
+    width_ = board.Width();
+    height_ = board.Height();
+    tiles_.Clear();
+    grid_.assign(static_cast<size_t>(width_) * height_, TileHandle{});
 
-    for (int y = 0; y < Board::kHeight; ++y)
+    for (int y = 0; y < height_; ++y)
     {
-        for (int x = 0; x < Board::kWidth; ++x)
+        for (int x = 0; x < width_; ++x)
         {
             const IVec2 c {x, y};
             const SDL_Rect r = CellRect(c, layout);
             VisualTile t;
-            t.type = board.Get(c);
-            t.cell = c;
+            t.info.type = board.Get(c);
+            t.info.special = board.GetSpecial(c);
+            t.info.cell = c;
             t.x = static_cast<float>(r.x);
             t.y = static_cast<float>(r.y);
             t.alpha = 1.0f;
             t.sx = t.sy = 1.0f;
-            tiles_.push_back(t);
+            grid_[y * width_ + x] = tiles_.Insert(t);
         }
     }
 }
 
 void VisualBoard::SnapToLayout(const BoardLayout & layout)
 {
-    for (auto & t : tiles_)
+    float * x = tiles_.Current(TweenProp::X);
+    float * y = tiles_.Current(TweenProp::Y);
+    float * sx = tiles_.Current(TweenProp::ScaleX);
+    float * sy = tiles_.Current(TweenProp::ScaleY);
+    for (size_t i = 0; i < tiles_.Size(); ++i)
     {
-        const SDL_Rect r = CellRect(t.cell, layout);
-        t.x = static_cast<float>(r.x);
-        t.y = static_cast<float>(r.y);
-        t.sx = t.sy = 1.0f;
+        const SDL_Rect r = CellRect(tiles_.Info(i).cell, layout);
+        x[i] = static_cast<float>(r.x);
+        y[i] = static_cast<float>(r.y);
+        sx[i] = sy[i] = 1.0f;
     }
+    tiles_.SavePrevious();
 }
 
 uint64_t VisualBoard::AnimateSwap(const IVec2 & a, const IVec2 & b, const BoardLayout & layout,
                                   AnimationSystem & anims, float seconds, uint64_t group_id)
 {
-    VisualTile * ta = nullptr;
-    VisualTile * tb = nullptr;
-    for (auto & t : tiles_)
-    {
-        if (t.cell.x == a.x && t.cell.y == a.y) ta = &t;
-        if (t.cell.x == b.x && t.cell.y == b.y) tb = &t;
-    }
-    if (!ta || !tb) return 0;
+    const TileHandle ha = FindTile(a);
+    const TileHandle hb = FindTile(b);
+    const uint32_t ta = tiles_.Find(ha);
+    const uint32_t tb = tiles_.Find(hb);
+    if (ta == TileStore::kNoTile || tb == TileStore::kNoTile) return 0;
 
     const SDL_Rect ra = CellRect(a, layout);
     const SDL_Rect rb = CellRect(b, layout);
 
-    const float ax0 = ta->x, ay0 = ta->y;
-    const float bx0 = tb->x, by0 = tb->y;
+    const float * x = tiles_.Current(TweenProp::X);
+    const float * y = tiles_.Current(TweenProp::Y);
+    const float ax0 = x[ta], ay0 = y[ta];
+    const float bx0 = x[tb], by0 = y[tb];
 
     const float ax1 = static_cast<float>(rb.x);
     const float ay1 = static_cast<float>(rb.y);
@@ -73,82 +86,74 @@ uint64_t VisualBoard::AnimateSwap(const IVec2 & a, const IVec2 & b, const BoardL
 
     const uint64_t g = (group_id == 0) ? anims.BeginGroup() : group_id;
 
-    anims.Add(Animation{
-        0.0f, seconds,
-        [ta, ax0, ay0, ax1, ay1](float p){ ta->x = Lerp(ax0, ax1, p); ta->y = Lerp(ay0, ay1, p); },
-        nullptr, g, EaseOutCubic
-    });
-
-    anims.Add(Animation{
-        0.0f, seconds,
-        [tb, bx0, by0, bx1, by1](float p){ tb->x = Lerp(bx0, bx1, p); tb->y = Lerp(by0, by1, p); },
-        nullptr, g, EaseOutCubic
-    });
+    anims.Add(Tween{ha, TweenProp::X, ax0, ax1, seconds, Ease::OutCubic, 1.0f, g});
+    anims.Add(Tween{ha, TweenProp::Y, ay0, ay1, seconds, Ease::OutCubic, 1.0f, g});
+    anims.Add(Tween{hb, TweenProp::X, bx0, bx1, seconds, Ease::OutCubic, 1.0f, g});
+    anims.Add(Tween{hb, TweenProp::Y, by0, by1, seconds, Ease::OutCubic, 1.0f, g});
 
     if (group_id == 0) anims.EndGroup();
 
-    std::swap(ta->cell, tb->cell);
+    std::swap(tiles_.Info(ta).cell, tiles_.Info(tb).cell);
+    std::swap(grid_[a.y * width_ + a.x], grid_[b.y * width_ + b.x]);
     return g;
 }
 
-uint64_t VisualBoard::AnimateFadeMask(const std::vector<bool> & mask, AnimationSystem & anims,
+uint64_t VisualBoard::AnimateFadeMask(const DynamicBoard::Mask & mask, AnimationSystem & anims,
                                       float seconds, uint64_t group_id)
 {
     const uint64_t g = (group_id == 0) ? anims.BeginGroup() : group_id;
 
-    for (auto & t : tiles_)
-    {
-        const int idx = t.cell.y * Board::kWidth + t.cell.x;
-        if (idx >= 0 && idx < static_cast<int>(mask.size()) && mask[idx])
+    mask.ForEachSet([&](int idx) {
+        const TileHandle h = grid_[idx];
+        const uint32_t t = tiles_.Find(h);
+        if (t != TileStore::kNoTile)
         {
-            const float a0 = t.alpha;
-            anims.Add(Animation{
-                0.0f, seconds,
-                [&t, a0](float p){ t.alpha = Lerp(a0, 0.0f, p); },
-                nullptr, g, EaseLinear
-            });
+            anims.Add(Tween{h, TweenProp::Alpha, tiles_.Current(TweenProp::Alpha)[t], 0.0f, seconds, Ease::Linear, 1.0f, g});
         }
-    }
+    });
 
     if (group_id == 0) anims.EndGroup();
     return g;
 }
 
-uint64_t VisualBoard::AnimatePulseMask(const std::vector<bool> & mask, AnimationSystem & anims,
+uint64_t VisualBoard::AnimatePulseMask(const DynamicBoard::Mask & mask, AnimationSystem & anims,
                                        float seconds, float peak_scale, uint64_t group_id)
 {
     const uint64_t g = (group_id == 0) ? anims.BeginGroup() : group_id;
 
-    for (auto & t : tiles_)
-    {
-        const int idx = t.cell.y * Board::kWidth + t.cell.x;
-        if (idx >= 0 && idx < static_cast<int>(mask.size()) && mask[idx])
+    mask.ForEachSet([&](int idx) {
+        const TileHandle h = grid_[idx];
+        if (tiles_.Find(h) != TileStore::kNoTile)
         {
-            anims.Add(Animation{
-                0.0f, seconds,
-                [&t, peak_scale](float p){
-                    // Piecewise yoyo: grow then return
-                    float s = (p < 0.5f) ? Lerp(1.0f, peak_scale, p * 2.0f)
-                                         : Lerp(peak_scale, 1.0f, (p - 0.5f) * 2.0f);
-                    t.sx = t.sy = s;
-                },
-                nullptr, g, EaseOutCubic
-            });
+            // Piecewise yoyo: grow until halfway, then return
+            anims.Add(Tween{h, TweenProp::ScaleX, 1.0f, peak_scale, seconds, Ease::OutCubic, 0.5f, g});
+            anims.Add(Tween{h, TweenProp::ScaleY, 1.0f, peak_scale, seconds, Ease::OutCubic, 0.5f, g});
         }
-    }
+    });
 
     if (group_id == 0) anims.EndGroup();
     return g;
 }
 
-void VisualBoard::RemoveByMask(const std::vector<bool> & mask)
+void VisualBoard::ApplyTransforms(const std::vector<Transform> & created)
 {
-    tiles_.erase(std::remove_if(tiles_.begin(), tiles_.end(),
-                 [&mask](const VisualTile & t){
-                     const int idx = t.cell.y * Board::kWidth + t.cell.x;
-                     return idx >= 0 && idx < static_cast<int>(mask.size()) && mask[idx];
-                 }),
-                 tiles_.end());
+    for (const auto & tr : created)
+    {
+        const uint32_t t = tiles_.Find(FindTile(tr.at));
+        if (t != TileStore::kNoTile)
+        {
+            tiles_.Info(t).type = tr.type;
+            tiles_.Info(t).special = tr.special;
+        }
+    }
+}
+
+void VisualBoard::RemoveByMask(const DynamicBoard::Mask & mask)
+{
+    mask.ForEachSet([&](int idx) {
+        tiles_.Remove(grid_[idx]);
+        grid_[idx] = TileHandle{};
+    });
 }
 
 uint64_t VisualBoard::AnimateMoves(const std::vector<Move> & moves, const BoardLayout & layout,
@@ -156,28 +161,36 @@ uint64_t VisualBoard::AnimateMoves(const std::vector<Move> & moves, const BoardL
 {
     const uint64_t g = (group_id == 0) ? anims.BeginGroup() : group_id;
 
+    // A move's target may be another move's source, so every source is read
+    // and cleared before any target is written.
+    moving_.clear();
     for (const auto & m : moves)
     {
-        VisualTile * tv = nullptr;
-        for (auto & t : tiles_)
-        {
-            if (t.cell.x == m.from.x && t.cell.y == m.from.y) { tv = &t; break; }
-        }
-        if (!tv) continue;
+        const int from = m.from.y * width_ + m.from.x;
+        moving_.push_back(grid_[from]);
+        grid_[from] = TileHandle{};
+    }
+
+    for (size_t i = 0; i < moves.size(); ++i)
+    {
+        const Move & m = moves[i];
+        const TileHandle h = moving_[i];
+        const uint32_t t = tiles_.Find(h);
+        if (t == TileStore::kNoTile) continue;
+        grid_[m.to.y * width_ + m.to.x] = h;
 
         const SDL_Rect r1 = CellRect(m.to, layout);
-        const float x0 = tv->x, y0 = tv->y;
+        const float x0 = tiles_.Current(TweenProp::X)[t];
+        const float y0 = tiles_.Current(TweenProp::Y)[t];
         const float x1 = static_cast<float>(r1.x);
         const float y1 = static_cast<float>(r1.y);
 
-        anims.Add(Animation{
-            0.0f, seconds,
-            [tv, x0, y0, x1, y1](float p){ tv->x = Lerp(x0, x1, p); tv->y = Lerp(y0, y1, p); },
-            nullptr, g, EaseOutCubic
-        });
+        anims.Add(Tween{h, TweenProp::X, x0, x1, seconds, Ease::OutCubic, 1.0f, g});
+        anims.Add(Tween{h, TweenProp::Y, y0, y1, seconds, Ease::OutCubic, 1.0f, g});
 
-        tv->cell = m.to;
-        tv->sx = tv->sy = 1.0f;
+        tiles_.Info(t).cell = m.to;
+        tiles_.Current(TweenProp::ScaleX)[t] = 1.0f;
+        tiles_.Current(TweenProp::ScaleY)[t] = 1.0f;
     }
 
     if (group_id == 0) anims.EndGroup();
@@ -195,24 +208,18 @@ uint64_t VisualBoard::AnimateSpawns(const std::vector<Spawn> & spawns, const Boa
         const int start_y = layout.origin_y - (s.order_above + 1) * stride_px(layout);
 
         VisualTile t;
-        t.type = s.type;
-        t.cell = s.to;
+        t.info.type = s.type;
+        t.info.cell = s.to;
         t.x = static_cast<float>(rt.x);
         t.y = static_cast<float>(start_y);
         t.alpha = 1.0f;
         t.sx = t.sy = 1.0f;
-        tiles_.push_back(t);
+        const TileHandle h = tiles_.Insert(t);
+        grid_[s.to.y * width_ + s.to.x] = h;
 
-        VisualTile & ref = tiles_.back();
         const float y0 = static_cast<float>(start_y);
         const float y1 = static_cast<float>(rt.y);
-        const float x0 = static_cast<float>(rt.x);
-
-        anims.Add(Animation{
-            0.0f, seconds,
-            [&ref, x0, y0, y1](float p){ ref.x = x0; ref.y = Lerp(y0, y1, p); },
-            nullptr, g, EaseOutCubic
-        });
+        anims.Add(Tween{h, TweenProp::Y, y0, y1, seconds, Ease::OutCubic, 1.0f, g});
     }
 
     if (group_id == 0) anims.EndGroup();
@@ -224,23 +231,14 @@ uint64_t VisualBoard::AnimateBumpCells(const std::vector<IVec2> & cells, Animati
 {
     const uint64_t g = (group_id == 0) ? anims.BeginGroup() : group_id;
 
-    for (auto & t : tiles_)
+    for (const IVec2 & c : cells)
     {
-        const bool target = std::any_of(cells.begin(), cells.end(),
-            [&t](const IVec2 & c){ return c.x == t.cell.x && c.y == t.cell.y; });
-
-        if (!target) continue;
-
-        anims.Add(Animation{
-            0.0f, seconds,
-            [&t, peak_scale](float p){
-                // Quick bump: overshoot up then relax to 1.0
-                float s = (p < 0.6f) ? Lerp(1.0f, peak_scale, p / 0.6f)
-                                     : Lerp(peak_scale, 1.0f, (p - 0.6f) / 0.4f);
-                t.sx = t.sy = s;
-            },
-            nullptr, g, EaseOutBack
-        });
+        const TileHandle h = FindTile(c);
+        if (tiles_.Find(h) == TileStore::kNoTile) continue;
+
+        // Quick bump: overshoot up then relax to 1.0
+        anims.Add(Tween{h, TweenProp::ScaleX, 1.0f, peak_scale, seconds, Ease::OutBack, 0.6f, g});
+        anims.Add(Tween{h, TweenProp::ScaleY, 1.0f, peak_scale, seconds, Ease::OutBack, 0.6f, g});
     }
 
     if (group_id == 0) anims.EndGroup();
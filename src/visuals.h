@@ -2,6 +2,7 @@
 #include "types.h"
 #include "board.h"
 #include "animation.h"
+#include "tile_store.h"
 
 #include <vector>
 #include <optional>
@@ -9,24 +10,13 @@
 
 struct BoardLayout;
 
-// Visual representation of a single tile.
-struct VisualTile
-{
-    CellType type {CellType::Red};
-    IVec2 cell {0, 0};    // current target cell
-    float x {0.0f};       // top-left pixel position
-    float y {0.0f};
-    float alpha {1.0f};   // 0..1
-    float sx {1.0f};      // scale X
-    float sy {1.0f};      // scale Y
-};
-
 class VisualBoard
 {
 public:
-    void BuildFromBoard(const Board & board, const BoardLayout & layout);
+    void BuildFromBoard(const DynamicBoard & board, const BoardLayout & layout);
 
-    // Must be called when layout changes (e.g., window resize).
+    // Must be called when layout changes (e.g., window resize). Tiles jump to
+    // their cells without interpolation.
     void SnapToLayout(const BoardLayout & layout);
 
     // Animations:
@@ -35,14 +25,18 @@ public:
                          AnimationSystem & anims, float seconds, uint64_t group_id = 0);
 
     // Fade out matched cells by mask; does not remove tiles, only animates alpha.
-    uint64_t AnimateFadeMask(const std::vector<bool> & mask, AnimationSystem & anims,
+    uint64_t AnimateFadeMask(const DynamicBoard::Mask & mask, AnimationSystem & anims,
                              float seconds, uint64_t group_id = 0);
 
-    uint64_t AnimatePulseMask(const std::vector<bool> & mask, AnimationSystem & anims,
+    uint64_t AnimatePulseMask(const DynamicBoard::Mask & mask, AnimationSystem & anims,
                               float seconds, float peak_scale = 1.18f, uint64_t group_id = 0);
 
-    // Remove tiles that are true in mask (after fade completed).
-    void RemoveByMask(const std::vector<bool> & mask);
+    // Turn the tiles of matched cells that stay on the board into their special candies.
+    void ApplyTransforms(const std::vector<Transform> & created);
+
+    // Remove tiles that are true in mask (after fade completed). Tweens still
+    // running on them stop writing.
+    void RemoveByMask(const DynamicBoard::Mask & mask);
 
     // Animate falling moves (existing tiles moving to new cells).
     uint64_t AnimateMoves(const std::vector<Move> & moves, const BoardLayout & layout,
@@ -53,17 +47,30 @@ public:
                            AnimationSystem & anims, float seconds, uint64_t group_id = 0);
 
     // Small bounce after landing (used on all cells that just received a tile).
+    // Each cell should appear once.
     uint64_t AnimateBumpCells(const std::vector<IVec2> & cells, AnimationSystem & anims,
                               float seconds = 0.10f, float peak_scale = 1.10f, uint64_t group_id = 0);
 
-    const std::vector<VisualTile> & Tiles() const { return tiles_; }
+    // Dense, in no particular order.
+    const TileStore & Tiles() const { return tiles_; }
+    // What AnimationSystem::Update writes into.
+    TileStore & Store() { return tiles_; }
 
     // Render all tiles.
     void Draw(SDL_Renderer * r) const;
     
 private:
-    std::vector<VisualTile> tiles_;
+    TileStore tiles_;
+    // Tile at each cell (y * width + x), kept in step with TileInfo::cell by
+    // every operation that moves, adds or removes tiles.
+    std::vector<TileHandle> grid_;
+    // Handles in flight during AnimateMoves, scratch.
+    std::vector<TileHandle> moving_;
+    int width_ {0};
+    int height_ {0};
 
+    // The tile targeting cell c, or a handle that resolves to nothing.
+    TileHandle FindTile(const IVec2 & c) const;
     static SDL_Rect CellRect(const IVec2 & c, const BoardLayout & layout);
     static void SetColor(SDL_Renderer * r, CellType type, uint8_t alpha);
 };
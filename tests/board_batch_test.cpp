@@ -0,0 +1,161 @@
+// Checks that a board settled in a BoardBatch and stored back is the board a
+// plain Board cascade gives: same cells, score and RNG, and the same game
+// afterwards (reshuffles and the refills of later moves). Runs every kernel
+// set the CPU supports, with each board sharing the batch with others and
+// stored into a board that was used before. Exit status 0 when all agree.
+
+#include "board.h"
+#include "board_batch.h"
+#include "rng.h"
+#include "rules.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    // More than two blocks, the last one partly used.
+    constexpr int kBoards = 40;
+    constexpr int kMovesAfter = 8;
+
+    template <int W, int H>
+    bool SameBoard(const BasicBoard<W, H> & a, const BasicBoard<W, H> & b)
+    {
+        for (int i = 0; i < a.Cells(); ++i)
+        {
+            if (a.CellData()[i] != b.CellData()[i] || a.SpecialData()[i] != b.SpecialData()[i])
+            {
+                return false;
+            }
+        }
+        return a.RngState() == b.RngState();
+    }
+
+    // Plays the first valid swap up to 'moves' times, reshuffling like the game.
+    template <int W, int H>
+    void Play(BasicBoard<W, H> & board, int moves)
+    {
+        for (int i = 0; i < moves; ++i)
+        {
+            const auto swap = board.FindAnySwap();
+            if (!swap)
+            {
+                return;
+            }
+            if (PlayMove(board, swap->first, swap->second).valid)
+            {
+                board.EnsurePlayable();
+            }
+        }
+    }
+
+    // Generated boards with a block of cells overwritten, so most of them cascade.
+    template <int W, int H>
+    std::vector<BasicBoard<W, H>> MakePositions(const BasicBoard<W, H> & prototype, uint32_t seed)
+    {
+        std::vector<BasicBoard<W, H>> boards(kBoards, prototype);
+        CounterRng rng(SplitMix64(seed), 3);
+        for (int i = 0; i < kBoards; ++i)
+        {
+            BasicBoard<W, H> & b = boards[i];
+            b.GenerateInitial(seed + static_cast<uint32_t>(i));
+            for (int k = 0; k < b.Cells() / 4; ++k)
+            {
+                const IVec2 p {static_cast<int>(UniformBelow(rng, static_cast<uint32_t>(b.Width()))),
+                               static_cast<int>(UniformBelow(rng, static_cast<uint32_t>(b.Height())))};
+                b.Set(p, static_cast<CellType>(UniformBelow(rng, BasicBoard<W, H>::kColors)));
+            }
+        }
+        return boards;
+    }
+
+    template <int W, int H>
+    int64_t SettleBoard(BasicBoard<W, H> & board)
+    {
+        typename BasicBoard<W, H>::Mask mask;
+        std::vector<Move> moves(board.Cells());
+        std::vector<Spawn> spawns(board.Cells());
+        int64_t score = 0;
+        int groups = 0;
+        int cells = 0;
+        int move_count = 0;
+        while (board.FindMatches(mask, groups, cells))
+        {
+            score += MatchScore(cells, groups);
+            board.CollapseAndRefill(mask, moves.data(), spawns.data(), move_count);
+        }
+        return score;
+    }
+
+    template <int W, int H>
+    bool Run(const BasicBoard<W, H> & prototype, BatchIsa isa, const char * name)
+    {
+        BoardBatch batch(prototype.Width(), prototype.Height(), kBoards);
+        if (!batch.SetIsa(isa))
+        {
+            return true;
+        }
+        std::vector<int64_t> scores(kBoards);
+        BasicBoard<W, H> reused = prototype;
+        reused.GenerateInitial(999);
+
+        for (uint32_t seed = 1; seed <= 4; ++seed)
+        {
+            std::vector<BasicBoard<W, H>> alone = MakePositions(prototype, seed * 100);
+            for (int i = 0; i < kBoards; ++i)
+            {
+                batch.Load(i, alone[i]);
+            }
+            std::fill(scores.begin(), scores.end(), 0);
+            batch.Settle(scores.data());
+
+            for (int i = 0; i < kBoards; ++i)
+            {
+                const int64_t score = SettleBoard(alone[i]);
+                // A board that just played on, its RNG far from this lane's.
+                Play(reused, 3);
+                batch.Store(i, reused);
+
+                bool same = score == scores[i] && SameBoard(alone[i], reused);
+                alone[i].EnsurePlayable();
+                reused.EnsurePlayable();
+                alone[i].Shuffle();
+                reused.Shuffle();
+                same = same && SameBoard(alone[i], reused);
+                Play(alone[i], kMovesAfter);
+                Play(reused, kMovesAfter);
+                same = same && SameBoard(alone[i], reused);
+                if (!same)
+                {
+                    std::printf("FAIL %s %s seed %u board %d: stored board diverged\n",
+                                name, BatchIsaName(isa), seed, i);
+                    return false;
+                }
+            }
+        }
+        std::printf("ok   %s %s\n", name, BatchIsaName(isa));
+        return true;
+    }
+
+    template <int W, int H>
+    bool RunAll(const BasicBoard<W, H> & prototype, const char * name)
+    {
+        bool ok = true;
+        for (const BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Sse4, BatchIsa::Avx2})
+        {
+            ok = Run(prototype, isa, name) && ok;
+        }
+        return ok;
+    }
+}
+
+int main()
+{
+    bool ok = true;
+    ok = RunAll(Board(), "6x6") && ok;
+    ok = RunAll(Board8(), "8x8") && ok;
+    ok = RunAll(Board9(), "9x9") && ok;
+    ok = RunAll(DynamicBoard(16, 11), "16x11") && ok;
+    return ok ? 0 : 1;
+}
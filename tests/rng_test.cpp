@@ -0,0 +1,227 @@
+// Checks that random state is fully described by what the boards save: a
+// CounterRng depends only on (key, stream, position), whatever it drew
+// before, and a used board that takes over another board's cells and RNG
+// (SetRngWords, SetRngState, ReplayPlayer::Seek) goes on exactly like it.
+// Exit status 0 when every check passed.
+
+#include "board.h"
+#include "replay.h"
+#include "rng.h"
+#include "rules.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    constexpr int kDraws = 16;
+    constexpr uint32_t kSeeds = 20;
+
+    bool SameDraws(CounterRng a, CounterRng b)
+    {
+        for (int i = 0; i < kDraws; ++i)
+        {
+            if (a() != b())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Re-seeding a used generator, at every offset within a Philox block,
+    // must give the same words as a fresh one.
+    bool Reseed()
+    {
+        for (uint64_t used = 0; used < 9; ++used)
+        {
+            for (const uint64_t key : {uint64_t {5}, uint64_t {7}})
+            {
+                for (const uint64_t stream : {uint64_t {0}, uint64_t {1}, uint64_t {3}})
+                {
+                    CounterRng rng(5, 1);
+                    for (uint64_t i = 0; i < used; ++i)
+                    {
+                        rng();
+                    }
+                    rng.Seed(key, stream);
+                    if (!SameDraws(rng, CounterRng(key, stream)))
+                    {
+                        std::printf("FAIL reseed after %llu draws to key %llu stream %llu\n",
+                                    static_cast<unsigned long long>(used), static_cast<unsigned long long>(key),
+                                    static_cast<unsigned long long>(stream));
+                        return false;
+                    }
+                }
+            }
+        }
+        std::printf("ok   reseed\n");
+        return true;
+    }
+
+    // Discard and SetPosition land where sequential draws would, and each
+    // word equals the stateless PhiloxAt.
+    bool Positions()
+    {
+        constexpr uint64_t kKey = 0x1234567890ABCDEFull;
+        constexpr uint64_t kStream = 42;
+        CounterRng seq(kKey, kStream);
+        for (uint64_t n = 0; n < 64; ++n)
+        {
+            CounterRng skipped(kKey, kStream);
+            skipped.Discard(n);
+            CounterRng placed(kKey + 1, kStream);
+            placed();
+            placed.Seed(kKey, kStream);
+            placed.SetPosition(n);
+            const bool same = SameDraws(seq, skipped) && SameDraws(seq, placed) && seq.Position() == n;
+            if (!same || seq() != PhiloxAt(kKey, kStream, n))
+            {
+                std::printf("FAIL positions at word %llu\n", static_cast<unsigned long long>(n));
+                return false;
+            }
+        }
+        std::printf("ok   positions\n");
+        return true;
+    }
+
+    template <int W, int H>
+    bool SameBoard(const BasicBoard<W, H> & a, const BasicBoard<W, H> & b)
+    {
+        for (int i = 0; i < a.Cells(); ++i)
+        {
+            if (a.CellData()[i] != b.CellData()[i] || a.SpecialData()[i] != b.SpecialData()[i])
+            {
+                return false;
+            }
+        }
+        return a.RngState() == b.RngState();
+    }
+
+    // Plays the first valid swap up to 'moves' times, reshuffling like the game.
+    template <int W, int H>
+    void Play(BasicBoard<W, H> & board, int moves)
+    {
+        for (int i = 0; i < moves; ++i)
+        {
+            const auto swap = board.FindAnySwap();
+            if (!swap)
+            {
+                return;
+            }
+            if (PlayMove(board, swap->first, swap->second).valid)
+            {
+                board.EnsurePlayable();
+            }
+        }
+    }
+
+    // A used board takes over the cells and RNG of another one; both must
+    // then shuffle, regenerate and refill identically.
+    template <int W, int H>
+    bool RoundTrip(BasicBoard<W, H> source, const char * name)
+    {
+        BasicBoard<W, H> reused = source;
+        std::vector<uint64_t> words(2 + static_cast<size_t>(source.Width()));
+        for (uint32_t seed = 1; seed <= kSeeds; ++seed)
+        {
+            source.GenerateInitial(seed);
+            Play(source, static_cast<int>(seed % 7));
+            reused.GenerateInitial(seed + 1000);
+            Play(reused, 3);
+
+            source.GetRngWords(words.data());
+            BasicBoard<W, H> by_words = reused;
+            by_words.LoadCells(source.CellData(), source.SpecialData());
+            by_words.SetRngWords(words.data());
+
+            BasicBoard<W, H> by_state = reused;
+            by_state.LoadCells(source.CellData(), source.SpecialData());
+            const bool loaded = by_state.SetRngState(source.RngState());
+
+            bool same = loaded && SameBoard(source, by_words) && SameBoard(source, by_state);
+            source.Shuffle();
+            by_words.Shuffle();
+            by_state.Shuffle();
+            same = same && SameBoard(source, by_words) && SameBoard(source, by_state);
+            Play(source, 5);
+            Play(by_words, 5);
+            Play(by_state, 5);
+            same = same && SameBoard(source, by_words) && SameBoard(source, by_state);
+            if (!same)
+            {
+                std::printf("FAIL %s seed %u: restored board diverged\n", name, seed);
+                return false;
+            }
+        }
+        std::printf("ok   %s round trip\n", name);
+        return true;
+    }
+
+    // Seeking a used board ends in the same state as stepping a fresh one
+    // from the start, and the two keep agreeing afterwards.
+    bool Seek()
+    {
+        Board9 board;
+        board.GenerateInitial(77);
+        board.EnsurePlayable();
+        ReplayRecorder recorder;
+        recorder.Begin(board.Width(), board.Height(), 77, 4);
+        int64_t score = 0;
+        for (int i = 0; i < 40; ++i)
+        {
+            const auto swap = board.FindAnySwap();
+            if (!swap)
+            {
+                break;
+            }
+            recorder.RecordSwap(swap->first, swap->second);
+            const MoveOutcome out = PlayMove(board, swap->first, swap->second);
+            if (out.valid)
+            {
+                board.EnsurePlayable();
+            }
+            score += out.score;
+            recorder.OnSettled(board, score);
+        }
+        recorder.Finish(score);
+
+        for (const int target : {0, 3, 4, 9, 17, 32, 40})
+        {
+            Board9 stepped;
+            ReplayPlayer from_start(recorder.Get());
+            from_start.Reset(stepped);
+            while (from_start.Position() < target && from_start.Step(stepped))
+            {
+            }
+
+            Board9 seeked;
+            seeked.GenerateInitial(12345);
+            Play(seeked, 6);
+            ReplayPlayer player(recorder.Get());
+            bool same = player.Seek(seeked, target) && SameBoard(stepped, seeked);
+            stepped.Shuffle();
+            seeked.Shuffle();
+            same = same && SameBoard(stepped, seeked);
+            if (!same)
+            {
+                std::printf("FAIL seek to move %d\n", target);
+                return false;
+            }
+        }
+        std::printf("ok   seek\n");
+        return true;
+    }
+}
+
+int main()
+{
+    bool ok = true;
+    ok = Reseed() && ok;
+    ok = Positions() && ok;
+    ok = RoundTrip(Board(), "6x6") && ok;
+    ok = RoundTrip(Board9(), "9x9") && ok;
+    ok = RoundTrip(DynamicBoard(11, 7), "11x7") && ok;
+    ok = Seek() && ok;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,213 @@
+// BoardBatch benchmark: settles the same random positions with Board and with
+// BoardBatch under every supported instruction set, checks that the scores
+// and valid move counts agree, and reports positions/sec.
+//
+//   match3_batchbench --positions 100000 --sizes 6x6,8x8,9x9,16x16 --seed 1
+
+#include "board.h"
+#include "board_batch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct BenchOptions
+    {
+        int positions {65536};
+        uint32_t seed {1};
+        int batch {4096};
+        std::vector<std::pair<int, int>> sizes {{6, 6}, {8, 8}, {9, 9}, {16, 16}};
+    };
+
+    struct Result
+    {
+        int64_t score {0};
+        int64_t moves {0};
+    };
+
+    bool ParseSizes(const char * s, std::vector<std::pair<int, int>> & out)
+    {
+        out.clear();
+        while (*s)
+        {
+            int w = 0;
+            int h = 0;
+            int used = 0;
+            if (std::sscanf(s, "%dx%d%n", &w, &h, &used) != 2 || w < 3 || h < 3 ||
+                w > BoardBatch::kMaxSide || h > BoardBatch::kMaxSide)
+            {
+                return false;
+            }
+            out.emplace_back(w, h);
+            s += used;
+            if (*s == ',') ++s;
+        }
+        return !out.empty();
+    }
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: match3_batchbench [--positions N] [--seed S] [--batch B]\n"
+            "                         [--sizes WxH,WxH,...]   (sides 3..16)\n");
+    }
+
+    bool ParseArgs(int argc, char ** argv, BenchOptions & opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char * arg = argv[i];
+            const char * val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!val) { PrintUsage(); std::exit(2); } ++i; return val; };
+
+            if (!std::strcmp(arg, "--positions"))  opt.positions = std::atoi(need());
+            else if (!std::strcmp(arg, "--seed"))  opt.seed = static_cast<uint32_t>(std::strtoul(need(), nullptr, 10));
+            else if (!std::strcmp(arg, "--batch")) opt.batch = std::atoi(need());
+            else if (!std::strcmp(arg, "--sizes"))
+            {
+                if (!ParseSizes(need(), opt.sizes)) { PrintUsage(); return false; }
+            }
+            else
+            {
+                PrintUsage();
+                return false;
+            }
+        }
+        return opt.positions > 0 && opt.batch > 0;
+    }
+
+    // Unsettled starting positions: a generated board with a random block of
+    // cells overwritten, so most of them cascade.
+    template <typename BoardT>
+    std::vector<BoardT> MakePositions(const BenchOptions & opt, const BoardT & prototype)
+    {
+        std::vector<BoardT> boards(opt.positions, prototype);
+        CounterRng rng(opt.seed, 0);
+        for (int i = 0; i < opt.positions; ++i)
+        {
+            BoardT & b = boards[i];
+            b.GenerateInitial(opt.seed + static_cast<uint32_t>(i), 1);
+            const int writes = b.Cells() / 4;
+            for (int k = 0; k < writes; ++k)
+            {
+                const IVec2 p {static_cast<int>(UniformBelow(rng, b.Width())), static_cast<int>(UniformBelow(rng, b.Height()))};
+                b.Set(p, static_cast<CellType>(UniformBelow(rng, Board::kColors)));
+            }
+        }
+        return boards;
+    }
+
+    double Seconds(std::chrono::steady_clock::time_point t0)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    template <typename BoardT>
+    Result SettleBoards(std::vector<BoardT> boards, double & sec)
+    {
+        Result r;
+        typename BoardT::Mask mask;
+        std::vector<Move> moves;
+        std::vector<Spawn> spawns;
+        const auto t0 = std::chrono::steady_clock::now();
+        for (BoardT & b : boards)
+        {
+            moves.resize(b.Cells());
+            spawns.resize(b.Cells());
+            int groups = 0;
+            int cells = 0;
+            int move_count = 0;
+            while (b.FindMatches(mask, groups, cells))
+            {
+                r.score += MatchScore(cells, groups);
+                b.CollapseAndRefill(mask, moves.data(), spawns.data(), move_count);
+            }
+            r.moves += b.ValidMoveCount();
+        }
+        sec = Seconds(t0);
+        return r;
+    }
+
+    template <typename BoardT>
+    Result SettleBatch(const BenchOptions & opt, const std::vector<BoardT> & boards, BatchIsa isa, double & sec)
+    {
+        Result r;
+        const int size = std::min(opt.batch, opt.positions);
+        BoardBatch batch(boards[0].Width(), boards[0].Height(), size);
+        batch.SetIsa(isa);
+        std::vector<int64_t> scores(size);
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int first = 0; first < opt.positions; first += size)
+        {
+            const int n = std::min(size, opt.positions - first);
+            for (int i = 0; i < n; ++i) batch.Load(i, boards[first + i]);
+            // A short last batch re-settles stale lanes; only the first n count.
+            std::fill(scores.begin(), scores.end(), 0);
+            batch.Settle(scores.data());
+            batch.CountValidMoves();
+            for (int i = 0; i < n; ++i)
+            {
+                r.score += scores[i];
+                r.moves += batch.ValidMoveCount(i);
+            }
+        }
+        sec = Seconds(t0);
+        return r;
+    }
+
+    template <typename BoardT>
+    bool Bench(const BenchOptions & opt, const BoardT & prototype)
+    {
+        const std::vector<BoardT> boards = MakePositions(opt, prototype);
+        bool ok = true;
+        auto report = [&](const char * name, const Result & r, const Result & ref, double sec, double base) {
+            const bool same = r.score == ref.score && r.moves == ref.moves;
+            ok = ok && same;
+            std::printf("%5dx%-5d %-8s %10.3f %14.0f %8.2fx %14lld %s\n", prototype.Width(), prototype.Height(), name, sec,
+                        opt.positions / std::max(sec, 1e-9), base / std::max(sec, 1e-9),
+                        static_cast<long long>(r.score), same ? "" : "MISMATCH");
+        };
+
+        double base = 0;
+        const Result ref = SettleBoards(boards, base);
+        report("board", ref, ref, base, base);
+        for (BatchIsa isa : {BatchIsa::Scalar, BatchIsa::Sse4, BatchIsa::Avx2})
+        {
+            if (!BatchIsaSupported(isa)) continue;
+            double sec = 0;
+            const Result r = SettleBatch(opt, boards, isa, sec);
+            report(BatchIsaName(isa), r, ref, sec, base);
+        }
+        return ok;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    BenchOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        return 2;
+    }
+
+    std::printf("%d positions, batches of %d; settle every position, then count valid swaps\n",
+                opt.positions, opt.batch);
+    std::printf("%11s %-8s %10s %14s %9s %14s\n", "size", "kernels", "sec", "positions/sec", "speedup", "score");
+
+    bool ok = true;
+    for (const auto & [w, h] : opt.sizes)
+    {
+        if (w == 6 && h == 6)       ok = Bench(opt, Board()) && ok;
+        else if (w == 8 && h == 8)  ok = Bench(opt, Board8()) && ok;
+        else if (w == 9 && h == 9)  ok = Bench(opt, Board9()) && ok;
+        else                        ok = Bench(opt, DynamicBoard(w, h)) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+// Position corpus builder and scanner (format in src/core/corpus.h).
+//
+//   match3_corpus build out.m3pc --positions 10000000 --size 8x8 --policy greedy
+//   match3_corpus scan out.m3pc [--check]
+//
+// build plays games with a move policy and stores every position a move is
+// made from, labelled with the score that move earned. scan maps the file and
+// unpacks every record once, reporting records/sec and MB/sec; --check also
+// validates the cell codes, reloads each record into a board to compare its
+// Zobrist hash and looks each one up through the index.
+
+#include "board.h"
+#include "corpus.h"
+#include "policies.h"
+#include "rules.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct CorpusOptions
+    {
+        std::string command;
+        std::string path;
+        int64_t positions {1000000};
+        uint32_t seed {1};
+        PolicyKind policy {PolicyKind::Random};
+        int max_moves {200};
+        int width {8};
+        int height {8};
+        bool index {true};
+        bool specials {true};
+        bool check {false};
+    };
+
+    bool ParseSize(const char * s, int & w, int & h)
+    {
+        return std::sscanf(s, "%dx%d", &w, &h) == 2 && w >= 3 && h >= 3 &&
+               w <= kMaxBoardSide && h <= kMaxBoardSide;
+    }
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: match3_corpus build <file> [--positions N] [--size WxH] [--seed S]\n"
+            "                     [--policy random|first|greedy] [--max-moves M]\n"
+            "                     [--no-index] [--no-specials]\n"
+            "       match3_corpus scan <file> [--check]\n");
+    }
+
+    bool ParseArgs(int argc, char ** argv, CorpusOptions & opt)
+    {
+        if (argc < 3)
+        {
+            PrintUsage();
+            return false;
+        }
+        opt.command = argv[1];
+        opt.path = argv[2];
+        for (int i = 3; i < argc; ++i)
+        {
+            const char * arg = argv[i];
+            const char * val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!val) { PrintUsage(); std::exit(2); } ++i; return val; };
+
+            if (!std::strcmp(arg, "--positions"))        opt.positions = std::atoll(need());
+            else if (!std::strcmp(arg, "--seed"))        opt.seed = static_cast<uint32_t>(std::strtoul(need(), nullptr, 10));
+            else if (!std::strcmp(arg, "--max-moves"))   opt.max_moves = std::atoi(need());
+            else if (!std::strcmp(arg, "--no-index"))    opt.index = false;
+            else if (!std::strcmp(arg, "--no-specials")) opt.specials = false;
+            else if (!std::strcmp(arg, "--check"))       opt.check = true;
+            else if (!std::strcmp(arg, "--policy"))
+            {
+                if (!ParsePolicy(need(), opt.policy)) { PrintUsage(); return false; }
+            }
+            else if (!std::strcmp(arg, "--size"))
+            {
+                if (!ParseSize(need(), opt.width, opt.height)) { PrintUsage(); return false; }
+            }
+            else
+            {
+                PrintUsage();
+                return false;
+            }
+        }
+        if (opt.command != "build" && opt.command != "scan")
+        {
+            PrintUsage();
+            return false;
+        }
+        return opt.positions > 0 && opt.max_moves > 0;
+    }
+
+    template <int W, int H>
+    int Build(BasicBoard<W, H> board, const CorpusOptions & opt)
+    {
+        CorpusWriter writer;
+        if (!writer.Open(opt.path, board.Width(), board.Height(), opt.specials, opt.index))
+        {
+            std::fprintf(stderr, "cannot create %s\n", opt.path.c_str());
+            return 1;
+        }
+
+        // The position a move is made from, kept until the move's score is known.
+        std::vector<CellType> cells(board.Cells());
+        std::vector<Special> specials(board.Cells());
+
+        const auto t0 = std::chrono::steady_clock::now();
+        bool ok = true;
+        for (int64_t game = 0; ok && writer.Count() < opt.positions; ++game)
+        {
+            board.GenerateInitial(opt.seed + static_cast<uint32_t>(game));
+            if (!board.EnsurePlayable())
+            {
+                std::fprintf(stderr, "no playable %dx%d board\n", board.Width(), board.Height());
+                return 1;
+            }
+            CounterRng policy_rng(SplitMix64(opt.seed), static_cast<uint64_t>(game));
+
+            for (int move = 0; ok && move < opt.max_moves && writer.Count() < opt.positions; ++move)
+            {
+                const SwapChoice choice = ChooseMove(opt.policy, board, policy_rng);
+                if (!choice)
+                {
+                    break;
+                }
+                const uint64_t hash = board.Hash();
+                std::copy(board.CellData(), board.CellData() + board.Cells(), cells.begin());
+                std::copy(board.SpecialData(), board.SpecialData() + board.Cells(), specials.begin());
+
+                // A board that cannot be reshuffled has no move left, which
+                // ends the game at the next ChooseMove.
+                const MoveOutcome out = PlayMove(board, choice->first, choice->second);
+                if (out.valid)
+                {
+                    board.EnsurePlayable();
+                }
+                // Labels are 32-bit; only huge boards ever reach the clamp.
+                const int32_t label = static_cast<int32_t>(std::min<int64_t>(out.score, INT32_MAX));
+                ok = writer.Add(hash, cells.data(), specials.data(), label);
+            }
+        }
+        ok = writer.Finish() && ok;
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        if (!ok)
+        {
+            std::fprintf(stderr, "write to %s failed\n", opt.path.c_str());
+            return 1;
+        }
+
+        const double bytes = static_cast<double>(writer.Count()) * CorpusRecordSize(board.Cells(), opt.specials);
+        std::printf("%lld positions  %dx%d  record %zu bytes  %.1f MB  %.3f s  positions/sec %.0f\n",
+                    static_cast<long long>(writer.Count()), board.Width(), board.Height(),
+                    CorpusRecordSize(board.Cells(), opt.specials), bytes / 1e6, sec,
+                    static_cast<double>(writer.Count()) / std::max(sec, 1e-9));
+        return 0;
+    }
+
+    // Reloads every record into a board: the stored hash must match and the
+    // index must find the record.
+    template <int W, int H>
+    int64_t Check(const PositionCorpus & corpus, BasicBoard<W, H> board)
+    {
+        int64_t bad = 0;
+        for (int64_t i = 0; i < corpus.Size(); ++i)
+        {
+            const PositionCorpus::Record r = corpus[i];
+            r.Load(board);
+            bool listed = false;
+            corpus.Find(r.Hash(), [&](int64_t record) { listed = listed || record == i; });
+            if (board.Hash() != r.Hash() || !listed)
+            {
+                ++bad;
+            }
+        }
+        return bad;
+    }
+
+    int Scan(const CorpusOptions & opt)
+    {
+        PositionCorpus corpus;
+        if (!corpus.Open(opt.path))
+        {
+            std::fprintf(stderr, "%s is not a readable corpus\n", opt.path.c_str());
+            return 1;
+        }
+
+        std::vector<CellType> cells(corpus.Cells());
+        std::vector<Special> specials(corpus.Cells());
+        int64_t color_hist[static_cast<int>(CellType::ColorBomb) + 1] = {};
+        int64_t special_cells = 0;
+        int64_t value_sum = 0;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        corpus.ForEach([&](const PositionCorpus::Record & r) {
+            r.Unpack(cells.data(), specials.data());
+            for (int i = 0; i < corpus.Cells(); ++i)
+            {
+                ++color_hist[static_cast<int>(cells[i])];
+                special_cells += specials[i] != Special::None;
+            }
+            value_sum += r.Value();
+        });
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        const double bytes = static_cast<double>(corpus.Size()) * static_cast<double>(corpus.RecordSize());
+        std::printf("%lld positions  %dx%d  record %zu bytes  specials %s  index %s\n",
+                    static_cast<long long>(corpus.Size()), corpus.Width(), corpus.Height(), corpus.RecordSize(),
+                    corpus.HasSpecials() ? "yes" : "no", corpus.HasIndex() ? "yes" : "no");
+        std::printf("scan %.3f s  positions/sec %.0f  MB/sec %.0f\n", sec,
+                    static_cast<double>(corpus.Size()) / std::max(sec, 1e-9), bytes / 1e6 / std::max(sec, 1e-9));
+        std::printf("mean value %.3f  special cells %lld\ncells:",
+                    corpus.Size() ? static_cast<double>(value_sum) / static_cast<double>(corpus.Size()) : 0.0,
+                    static_cast<long long>(special_cells));
+        for (int64_t n : color_hist) std::printf(" %lld", static_cast<long long>(n));
+        std::printf("\n");
+
+        if (!opt.check)
+        {
+            return 0;
+        }
+
+        const int64_t invalid = corpus.Validate();
+        if (invalid >= 0)
+        {
+            std::printf("check: record %lld holds an invalid cell code\n", static_cast<long long>(invalid));
+            return 1;
+        }
+        const int w = corpus.Width();
+        const int h = corpus.Height();
+        int64_t bad = 0;
+        if (w == 6 && h == 6)       bad = Check(corpus, Board());
+        else if (w == 8 && h == 8)  bad = Check(corpus, Board8());
+        else if (w == 9 && h == 9)  bad = Check(corpus, Board9());
+        else                        bad = Check(corpus, DynamicBoard(w, h));
+        std::printf("check: %lld bad records\n", static_cast<long long>(bad));
+        return bad ? 1 : 0;
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    CorpusOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        return 2;
+    }
+    if (opt.command == "scan")
+    {
+        return Scan(opt);
+    }
+
+    const int w = opt.width;
+    const int h = opt.height;
+    if (w == 6 && h == 6)       return Build(Board(), opt);
+    else if (w == 8 && h == 8)  return Build(Board8(), opt);
+    else if (w == 9 && h == 9)  return Build(Board9(), opt);
+    else                        return Build(DynamicBoard(w, h), opt);
+}
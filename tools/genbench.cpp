@@ -0,0 +1,142 @@
+// Initial-board generator benchmark: generates boards at several sizes,
+// checks every one (no match, at least --moves valid swaps) and reports
+// boards/sec.
+//
+//   match3_genbench --boards 1000000 --sizes 6x6,8x8,9x9,16x16 --moves 3
+
+#include "board.h"
+#include "work_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    struct BenchOptions
+    {
+        int64_t boards {200000};
+        uint32_t seed {1};
+        int threads {1};
+        int moves {1};
+        std::vector<std::pair<int, int>> sizes {{6, 6}, {8, 8}, {9, 9}, {16, 16}};
+    };
+
+    bool ParseSizes(const char * s, std::vector<std::pair<int, int>> & out)
+    {
+        out.clear();
+        while (*s)
+        {
+            int w = 0;
+            int h = 0;
+            int used = 0;
+            if (std::sscanf(s, "%dx%d%n", &w, &h, &used) != 2 || w < 3 || h < 3 ||
+                w > kMaxBoardSide || h > kMaxBoardSide)
+            {
+                return false;
+            }
+            out.emplace_back(w, h);
+            s += used;
+            if (*s == ',') ++s;
+        }
+        return !out.empty();
+    }
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: match3_genbench [--boards N] [--seed S] [--threads T] [--moves K]\n"
+            "                       [--sizes WxH,WxH,...]\n");
+    }
+
+    bool ParseArgs(int argc, char ** argv, BenchOptions & opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char * arg = argv[i];
+            const char * val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!val) { PrintUsage(); std::exit(2); } ++i; return val; };
+
+            if (!std::strcmp(arg, "--boards"))       opt.boards = std::atoll(need());
+            else if (!std::strcmp(arg, "--seed"))    opt.seed = static_cast<uint32_t>(std::strtoul(need(), nullptr, 10));
+            else if (!std::strcmp(arg, "--threads")) opt.threads = std::atoi(need());
+            else if (!std::strcmp(arg, "--moves"))   opt.moves = std::atoi(need());
+            else if (!std::strcmp(arg, "--sizes"))
+            {
+                if (!ParseSizes(need(), opt.sizes)) { PrintUsage(); return false; }
+            }
+            else
+            {
+                PrintUsage();
+                return false;
+            }
+        }
+        return opt.boards > 0 && opt.moves >= 0;
+    }
+
+    template <typename BoardT>
+    void Bench(const BenchOptions & opt, const WorkStealingPool & pool, const BoardT & prototype)
+    {
+        std::atomic<int64_t> failures {0};
+        std::atomic<int64_t> move_sum {0};
+        const int want = std::min(opt.moves, prototype.MaxPlantedMoves());
+
+        const auto t0 = std::chrono::steady_clock::now();
+        pool.ParallelFor(opt.boards, 1024, [&](int64_t begin, int64_t end, int) {
+            BoardT board = prototype;
+            typename BoardT::Mask mask;
+            int64_t bad = 0;
+            int64_t moves = 0;
+            for (int64_t i = begin; i < end; ++i)
+            {
+                board.GenerateInitial(opt.seed + static_cast<uint32_t>(i), opt.moves);
+                int groups = 0;
+                int cells = 0;
+                if (board.FindMatches(mask, groups, cells) || board.ValidMoveCount() < want)
+                {
+                    ++bad;
+                }
+                moves += board.ValidMoveCount();
+            }
+            failures += bad;
+            move_sum += moves;
+        });
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::printf("%5dx%-5d %12lld %10.3f %14.0f %12.2f %10d %10lld\n",
+                    prototype.Width(), prototype.Height(), static_cast<long long>(opt.boards), sec,
+                    static_cast<double>(opt.boards) / std::max(sec, 1e-9),
+                    static_cast<double>(move_sum.load()) / static_cast<double>(opt.boards),
+                    want, static_cast<long long>(failures.load()));
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    BenchOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        return 2;
+    }
+
+    const WorkStealingPool pool(opt.threads);
+    std::printf("threads %d, --moves %d (timing includes the per-board check)\n",
+                pool.ThreadCount(), opt.moves);
+    std::printf("%11s %12s %10s %14s %12s %10s %10s\n",
+                "size", "boards", "sec", "boards/sec", "moves/board", "planted", "failures");
+
+    for (const auto & [w, h] : opt.sizes)
+    {
+        if (w == 6 && h == 6)       Bench(opt, pool, Board());
+        else if (w == 8 && h == 8)  Bench(opt, pool, Board8());
+        else if (w == 9 && h == 9)  Bench(opt, pool, Board9());
+        else                        Bench(opt, pool, DynamicBoard(w, h));
+    }
+    return 0;
+}
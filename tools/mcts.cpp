@@ -0,0 +1,213 @@
+#include "mcts.h"
+#include "policies.h"
+#include "rules.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Same cells at a different depth have a different remaining horizon.
+    constexpr uint64_t DepthKey(int depth)
+    {
+        return SplitMix64(0xD1B54A32D192ED03ull + static_cast<uint64_t>(depth));
+    }
+
+    struct PathStep
+    {
+        uint64_t key;
+        int edge;
+        int depth;
+    };
+
+    // UCB1 with the exploration term scaled by the node's mean return, so one
+    // constant works whatever the score range. Untried edges go first.
+    int SelectEdge(const TranspositionTable::Node & node, double exploration)
+    {
+        int64_t visits = 0;
+        double total = 0.0;
+        for (size_t i = 0; i < node.edges.size(); ++i)
+        {
+            const auto & e = node.edges[i];
+            if (e.visits == 0) return static_cast<int>(i);
+            visits += e.visits;
+            total += e.total;
+        }
+
+        const double scale = std::max(1.0, total / static_cast<double>(visits));
+        const double log_n = std::log(static_cast<double>(node.visits));
+        int best = 0;
+        double best_ucb = -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < node.edges.size(); ++i)
+        {
+            const auto & e = node.edges[i];
+            const double n = static_cast<double>(e.visits);
+            const double ucb = e.total / n + exploration * scale * std::sqrt(log_n / n);
+            if (ucb > best_ucb)
+            {
+                best_ucb = ucb;
+                best = static_cast<int>(i);
+            }
+        }
+        return best;
+    }
+
+    // Plays a move the way the game does: resolve, then reshuffle if deadlocked.
+    // If no reshuffle works the board keeps no valid move, which ends the playout.
+    template <int W, int H>
+    int64_t PlayAndSettle(BasicBoard<W, H> & board, const IVec2 & a, const IVec2 & b)
+    {
+        const MoveOutcome out = PlayMove(board, a, b);
+        if (out.valid)
+        {
+            board.EnsurePlayable();
+        }
+        return out.score;
+    }
+}
+
+template <int W, int H>
+SearchResult SearchBoard(const BasicBoard<W, H> & root, const SearchOptions & opt, const WorkStealingPool & pool)
+{
+    using BoardT = BasicBoard<W, H>;
+
+    SearchResult result;
+    result.valid_moves = root.ValidMoveCount();
+    if (result.valid_moves == 0 || opt.horizon <= 0)
+    {
+        return result;
+    }
+
+    TranspositionTable table(opt.max_nodes);
+    const typename BoardT::Snapshot snapshot = root.TakeSnapshot();
+    const uint64_t root_key = root.Hash() ^ DepthKey(0);
+
+    // One board and RNG pair per worker; each board gets its own spawn stream.
+    const int threads = pool.ThreadCount();
+    std::vector<BoardT> boards(threads, root);
+    std::vector<CounterRng> rngs;
+    for (int w = 0; w < threads; ++w)
+    {
+        boards[w].SeedRng(SplitMix64(opt.seed * 2 + 1 + static_cast<uint64_t>(w)));
+        rngs.emplace_back(SplitMix64(opt.seed * 2), static_cast<uint64_t>(w));
+    }
+
+    pool.ParallelFor(opt.iterations, 16, [&](int64_t begin, int64_t end, int worker) {
+        BoardT & board = boards[worker];
+        CounterRng & rng = rngs[worker];
+        std::vector<PathStep> path;
+        std::vector<int64_t> rewards(opt.horizon + 1, 0);
+
+        for (int64_t it = begin; it < end; ++it)
+        {
+            board.Restore(snapshot);
+            path.clear();
+            bool in_tree = true;
+            int depth = 0;
+
+            for (; depth < opt.horizon && board.HasValidMove(); ++depth)
+            {
+                SwapChoice move;
+                if (in_tree)
+                {
+                    const uint64_t key = board.Hash() ^ DepthKey(depth);
+                    int edge = -1;
+                    bool inserted = false;
+                    const bool present = table.Visit(key, [&](TranspositionTable::Node & node, bool fresh) {
+                        inserted = fresh;
+                        if (fresh)
+                        {
+                            board.ForEachValidSwap([&](const IVec2 & a, const IVec2 & b) {
+                                node.edges.push_back({a, b, 0, 0.0});
+                            });
+                        }
+                        edge = SelectEdge(node, opt.exploration);
+                        ++node.visits;
+                        ++node.edges[edge].visits;
+                        move = std::make_pair(node.edges[edge].a, node.edges[edge].b);
+                    });
+
+                    // A hash collision can hand back edges for a different board.
+                    if (present && board.IsValidSwap(move->first, move->second))
+                    {
+                        path.push_back({key, edge, depth});
+                    }
+                    else
+                    {
+                        move.reset();
+                    }
+                    in_tree = present && !inserted && move.has_value();
+                }
+
+                if (!move)
+                {
+                    move = ChooseRandomMove(board, rng);
+                }
+                rewards[depth] = PlayAndSettle(board, move->first, move->second);
+            }
+
+            // Return from depth d = rewards collected from d to the end of the playout.
+            rewards[depth] = 0;
+            for (int d = depth - 1; d >= 0; --d)
+            {
+                rewards[d] += rewards[d + 1];
+            }
+            for (const PathStep & step : path)
+            {
+                table.Update(step.key, [&](TranspositionTable::Node & node) {
+                    node.edges[step.edge].total += rewards[step.depth];
+                });
+            }
+        }
+    });
+
+    table.Update(root_key, [&](TranspositionTable::Node & node) {
+        for (const auto & e : node.edges)
+        {
+            RootMove m;
+            m.a = e.a;
+            m.b = e.b;
+            m.visits = e.visits;
+            m.mean = e.visits ? e.total / static_cast<double>(e.visits) : 0.0;
+            result.root_moves.push_back(m);
+        }
+    });
+    std::stable_sort(result.root_moves.begin(), result.root_moves.end(),
+                     [](const RootMove & x, const RootMove & y) { return x.visits > y.visits; });
+    if (!result.root_moves.empty())
+    {
+        result.expected_score = result.root_moves.front().mean;
+    }
+
+    // Baseline: uniform-random play over the same horizon.
+    if (opt.baseline_rollouts > 0)
+    {
+        std::vector<int64_t> sums(threads, 0);
+        pool.ParallelFor(opt.baseline_rollouts, 64, [&](int64_t begin, int64_t end, int worker) {
+            BoardT & board = boards[worker];
+            for (int64_t it = begin; it < end; ++it)
+            {
+                board.Restore(snapshot);
+                for (int depth = 0; depth < opt.horizon && board.HasValidMove(); ++depth)
+                {
+                    const SwapChoice move = ChooseRandomMove(board, rngs[worker]);
+                    sums[worker] += PlayAndSettle(board, move->first, move->second);
+                }
+            }
+        });
+
+        int64_t total = 0;
+        for (int64_t s : sums) total += s;
+        result.random_score = static_cast<double>(total) / static_cast<double>(opt.baseline_rollouts);
+    }
+
+    result.nodes = table.Size();
+    return result;
+}
+
+template SearchResult SearchBoard(const Board &, const SearchOptions &, const WorkStealingPool &);
+template SearchResult SearchBoard(const Board8 &, const SearchOptions &, const WorkStealingPool &);
+template SearchResult SearchBoard(const Board9 &, const SearchOptions &, const WorkStealingPool &);
+template SearchResult SearchBoard(const DynamicBoard &, const SearchOptions &, const WorkStealingPool &);
@@ -0,0 +1,133 @@
+#pragma once
+#include "board.h"
+#include "work_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Monte Carlo tree search over swaps, used to estimate how much a board is
+// worth to a strong player.
+//
+// Decision nodes are board states (cells Zobrist hash + depth). A swap leads
+// to a chance node: the refills after the cascade are random, so every visit
+// plays the move with fresh RNG draws and lands in whichever decision node the
+// outcome hashes to. Nodes live in one transposition table shared by all
+// workers; workers run iterations from the root independently and merge
+// through the table.
+
+struct SearchOptions
+{
+    int64_t iterations {20000};
+    int horizon {8};                 // moves per playout
+    double exploration {1.0};        // UCB constant, relative to the node's mean return
+    uint64_t seed {1};
+    size_t max_nodes {1u << 20};     // table stops growing here; deeper steps roll out
+    int64_t baseline_rollouts {4000}; // uniform-random playouts for comparison
+};
+
+struct RootMove
+{
+    IVec2 a;
+    IVec2 b;
+    int64_t visits {0};
+    double mean {0.0};
+};
+
+struct SearchResult
+{
+    int valid_moves {0};
+    double expected_score {0.0}; // mean return of the most visited root move
+    double random_score {0.0};   // mean return of uniform-random play
+    std::vector<RootMove> root_moves; // most visited first
+    size_t nodes {0};
+};
+
+// Hash map split into independently locked stripes; the stripe is picked by
+// the low bits of the (already well mixed) Zobrist key.
+class TranspositionTable
+{
+public:
+    struct Edge
+    {
+        IVec2 a;
+        IVec2 b;
+        int64_t visits {0};
+        double total {0.0};
+    };
+
+    struct Node
+    {
+        int64_t visits {0};
+        std::vector<Edge> edges;
+    };
+
+    explicit TranspositionTable(size_t max_nodes, int stripes_log2 = 6)
+        : stripes_(std::make_unique<Stripe[]>(size_t{1} << stripes_log2)),
+          stripe_mask_((uint64_t{1} << stripes_log2) - 1),
+          max_nodes_(max_nodes)
+    {
+    }
+
+    // Calls fn(node, inserted) under the stripe lock, creating the node if
+    // needed. Returns false (without calling fn) if it is absent and the table is full.
+    template <typename Fn>
+    bool Visit(uint64_t key, Fn && fn)
+    {
+        Stripe & s = stripes_[key & stripe_mask_];
+        std::lock_guard<std::mutex> lock(s.lock);
+        auto it = s.nodes.find(key);
+        const bool inserted = (it == s.nodes.end());
+        if (inserted)
+        {
+            if (size_.load(std::memory_order_relaxed) >= max_nodes_)
+            {
+                return false;
+            }
+            it = s.nodes.emplace(key, Node {}).first;
+            size_.fetch_add(1, std::memory_order_relaxed);
+        }
+        fn(it->second, inserted);
+        return true;
+    }
+
+    // Calls fn(node) under the stripe lock if the node exists.
+    template <typename Fn>
+    void Update(uint64_t key, Fn && fn)
+    {
+        Stripe & s = stripes_[key & stripe_mask_];
+        std::lock_guard<std::mutex> lock(s.lock);
+        auto it = s.nodes.find(key);
+        if (it != s.nodes.end())
+        {
+            fn(it->second);
+        }
+    }
+
+    size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+private:
+    struct Stripe
+    {
+        std::mutex lock;
+        std::unordered_map<uint64_t, Node> nodes;
+    };
+
+    std::unique_ptr<Stripe[]> stripes_;
+    uint64_t stripe_mask_ {0};
+    size_t max_nodes_ {0};
+    std::atomic<size_t> size_ {0};
+};
+
+// Searches from 'root' (left untouched) for opt.horizon moves per playout.
+// Results depend on thread timing when more than one worker runs.
+template <int W, int H>
+SearchResult SearchBoard(const BasicBoard<W, H> & root, const SearchOptions & opt, const WorkStealingPool & pool);
+
+extern template SearchResult SearchBoard(const Board &, const SearchOptions &, const WorkStealingPool &);
+extern template SearchResult SearchBoard(const Board8 &, const SearchOptions &, const WorkStealingPool &);
+extern template SearchResult SearchBoard(const Board9 &, const SearchOptions &, const WorkStealingPool &);
+extern template SearchResult SearchBoard(const DynamicBoard &, const SearchOptions &, const WorkStealingPool &);
@@ -0,0 +1,100 @@
+#pragma once
+#include "board.h"
+#include "rules.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Move-selection policies for the headless tools. Every policy only ever
+// returns valid swaps (or nothing when the board is deadlocked).
+
+enum class PolicyKind
+{
+    Random,     // uniform over the valid swaps
+    First,      // Board::FindAnySwap (what the hint shows)
+    Greedy      // largest immediate score, first step only
+};
+
+inline bool ParsePolicy(const std::string & name, PolicyKind & out)
+{
+    if (name == "random") { out = PolicyKind::Random; return true; }
+    if (name == "first")  { out = PolicyKind::First;  return true; }
+    if (name == "greedy") { out = PolicyKind::Greedy; return true; }
+    return false;
+}
+
+inline const char * PolicyName(PolicyKind kind)
+{
+    switch (kind)
+    {
+        case PolicyKind::Random: return "random";
+        case PolicyKind::First:  return "first";
+        case PolicyKind::Greedy: return "greedy";
+    }
+    return "?";
+}
+
+using SwapChoice = std::optional<std::pair<IVec2, IVec2>>;
+
+template <int W, int H>
+SwapChoice ChooseRandomMove(const BasicBoard<W, H> & board, CounterRng & rng)
+{
+    const int count = board.ValidMoveCount();
+    if (count == 0)
+    {
+        return std::nullopt;
+    }
+
+    int k = static_cast<int>(UniformBelow(rng, static_cast<uint32_t>(count)));
+    SwapChoice choice;
+    board.ForEachValidSwap([&](const IVec2 & a, const IVec2 & b) {
+        if (k-- == 0) choice = std::make_pair(a, b);
+    });
+    return choice;
+}
+
+// Scores each valid swap by its first match step only (no refill, so no RNG
+// is consumed); the board is restored after every probe.
+template <int W, int H>
+SwapChoice ChooseGreedyMove(BasicBoard<W, H> & board)
+{
+    typename BasicBoard<W, H>::Mask mask;
+    SwapChoice best;
+    int64_t best_score = -1;
+
+    // Collect first: probing mutates the valid-move set being iterated.
+    thread_local std::vector<std::pair<IVec2, IVec2>> swaps;
+    swaps.clear();
+    board.ForEachValidSwap([&](const IVec2 & a, const IVec2 & b) { swaps.emplace_back(a, b); });
+
+    for (const auto & [a, b] : swaps)
+    {
+        int groups = 0;
+        int cells = 0;
+        board.Swap(a, b);
+        board.FindMatches(mask, groups, cells);
+        board.Swap(a, b);
+        const int64_t score = MatchScore(cells, groups);
+        if (score > best_score)
+        {
+            best_score = score;
+            best = std::make_pair(a, b);
+        }
+    }
+    return best;
+}
+
+template <int W, int H>
+SwapChoice ChooseMove(PolicyKind kind, BasicBoard<W, H> & board, CounterRng & rng)
+{
+    switch (kind)
+    {
+        case PolicyKind::Random: return ChooseRandomMove(board, rng);
+        case PolicyKind::First:  return board.FindAnySwap();
+        case PolicyKind::Greedy: return ChooseGreedyMove(board);
+    }
+    return std::nullopt;
+}
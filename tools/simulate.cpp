@@ -0,0 +1,320 @@
+// Headless batch simulator: plays complete games with a fixed move policy
+// across all cores and prints aggregate statistics.
+//
+//   match3_sim --games 1000000 --policy greedy --seed 1 --size 6x6
+//
+// A game starts from GenerateInitial(seed) (reshuffled if it has no move, as
+// the game does) and ends at the first deadlock or after --max-moves moves.
+
+#include "board.h"
+#include "rules.h"
+#include "policies.h"
+#include "work_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    constexpr int kMaxCascadeBucket = 32;
+    // Score buckets per worker; the last one also takes every larger score,
+    // so huge boards cannot blow the histogram up (raise --score-bucket).
+    constexpr size_t kMaxScoreBuckets = size_t{1} << 20;
+
+    struct SimOptions
+    {
+        int64_t games {100000};
+        uint32_t seed {1};
+        int threads {0};
+        PolicyKind policy {PolicyKind::Random};
+        int max_moves {200};
+        int width {6};
+        int height {6};
+        int64_t grain {64};
+        int score_bucket {10};
+    };
+
+    struct SimStats
+    {
+        int64_t games {0};
+        int64_t moves {0};
+        int64_t deadlocks {0};
+        int64_t cut_cascades {0};                   // moves stopped at kMaxCascadeSteps
+        int64_t moves_to_deadlock_sum {0};
+        int64_t score_sum {0};
+        int64_t score_min {INT64_MAX};
+        int64_t score_max {0};
+        std::vector<int64_t> score_hist;            // bucket = score / score_bucket, capped
+        std::vector<int64_t> deadlock_hist;         // bucket = moves until deadlock
+        std::vector<int64_t> cascade_hist = std::vector<int64_t>(kMaxCascadeBucket + 1, 0);
+
+        void Merge(const SimStats & o)
+        {
+            games += o.games;
+            moves += o.moves;
+            deadlocks += o.deadlocks;
+            cut_cascades += o.cut_cascades;
+            moves_to_deadlock_sum += o.moves_to_deadlock_sum;
+            score_sum += o.score_sum;
+            score_min = std::min(score_min, o.score_min);
+            score_max = std::max(score_max, o.score_max);
+            AddInto(score_hist, o.score_hist);
+            AddInto(deadlock_hist, o.deadlock_hist);
+            AddInto(cascade_hist, o.cascade_hist);
+        }
+
+        static void Bump(std::vector<int64_t> & hist, size_t bucket)
+        {
+            if (hist.size() <= bucket) hist.resize(bucket + 1, 0);
+            ++hist[bucket];
+        }
+
+        static void AddInto(std::vector<int64_t> & dst, const std::vector<int64_t> & src)
+        {
+            if (dst.size() < src.size()) dst.resize(src.size(), 0);
+            for (size_t i = 0; i < src.size(); ++i) dst[i] += src[i];
+        }
+    };
+
+    bool ParseSize(const char * s, int & w, int & h)
+    {
+        return std::sscanf(s, "%dx%d", &w, &h) == 2 && w >= 3 && h >= 3 &&
+               w <= kMaxBoardSide && h <= kMaxBoardSide;
+    }
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: match3_sim [--games N] [--seed S] [--threads T] [--policy random|first|greedy]\n"
+            "                  [--max-moves M] [--size WxH] [--grain G] [--score-bucket B]\n");
+    }
+
+    bool ParseArgs(int argc, char ** argv, SimOptions & opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char * arg = argv[i];
+            const char * val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!val) { PrintUsage(); std::exit(2); } ++i; return val; };
+
+            if (!std::strcmp(arg, "--games"))             opt.games = std::atoll(need());
+            else if (!std::strcmp(arg, "--seed"))         opt.seed = static_cast<uint32_t>(std::strtoul(need(), nullptr, 10));
+            else if (!std::strcmp(arg, "--threads"))      opt.threads = std::atoi(need());
+            else if (!std::strcmp(arg, "--max-moves"))    opt.max_moves = std::atoi(need());
+            else if (!std::strcmp(arg, "--grain"))        opt.grain = std::atoll(need());
+            else if (!std::strcmp(arg, "--score-bucket")) opt.score_bucket = std::max(1, std::atoi(need()));
+            else if (!std::strcmp(arg, "--policy"))
+            {
+                if (!ParsePolicy(need(), opt.policy)) { PrintUsage(); return false; }
+            }
+            else if (!std::strcmp(arg, "--size"))
+            {
+                if (!ParseSize(need(), opt.width, opt.height)) { PrintUsage(); return false; }
+            }
+            else
+            {
+                PrintUsage();
+                return false;
+            }
+        }
+        return opt.games > 0 && opt.max_moves > 0;
+    }
+
+    template <int W, int H>
+    void PlayGame(BasicBoard<W, H> & board, int64_t game, const SimOptions & opt, SimStats & st)
+    {
+        board.GenerateInitial(opt.seed + static_cast<uint32_t>(game));
+        const bool playable = board.EnsurePlayable();
+
+        // One policy stream per game: results do not depend on scheduling.
+        CounterRng policy_rng(SplitMix64(opt.seed), static_cast<uint64_t>(game));
+        int64_t score = 0;
+        int moves = 0;
+        bool deadlocked = !playable;
+
+        while (!deadlocked && moves < opt.max_moves)
+        {
+            const SwapChoice choice = ChooseMove(opt.policy, board, policy_rng);
+            if (!choice)
+            {
+                deadlocked = true;
+                break;
+            }
+
+            const MoveOutcome out = PlayMove(board, choice->first, choice->second);
+            ++moves;
+            score += out.score;
+            st.cut_cascades += out.complete ? 0 : 1;
+            SimStats::Bump(st.cascade_hist, std::min(out.cascades, kMaxCascadeBucket));
+            deadlocked = out.deadlocked;
+        }
+
+        ++st.games;
+        st.moves += moves;
+        st.score_sum += score;
+        st.score_min = std::min(st.score_min, score);
+        st.score_max = std::max(st.score_max, score);
+        SimStats::Bump(st.score_hist, std::min(static_cast<size_t>(score / opt.score_bucket), kMaxScoreBuckets - 1));
+        if (deadlocked)
+        {
+            ++st.deadlocks;
+            st.moves_to_deadlock_sum += moves;
+            SimStats::Bump(st.deadlock_hist, static_cast<size_t>(moves));
+        }
+    }
+
+    template <typename BoardT>
+    SimStats Simulate(const SimOptions & opt, const WorkStealingPool & pool, BoardT prototype)
+    {
+        std::vector<SimStats> per_worker(pool.ThreadCount());
+
+        pool.ParallelFor(opt.games, opt.grain, [&](int64_t begin, int64_t end, int worker) {
+            BoardT board = prototype;
+            SimStats & st = per_worker[worker];
+            for (int64_t g = begin; g < end; ++g)
+            {
+                PlayGame(board, g, opt, st);
+            }
+        });
+
+        SimStats total;
+        for (const auto & st : per_worker)
+        {
+            total.Merge(st);
+        }
+        return total;
+    }
+
+    // Value at the given quantile of a histogram (bucket index).
+    int64_t Quantile(const std::vector<int64_t> & hist, int64_t total, double q)
+    {
+        const int64_t target = static_cast<int64_t>(q * static_cast<double>(total));
+        int64_t acc = 0;
+        for (size_t i = 0; i < hist.size(); ++i)
+        {
+            acc += hist[i];
+            if (acc > target) return static_cast<int64_t>(i);
+        }
+        return hist.empty() ? 0 : static_cast<int64_t>(hist.size() - 1);
+    }
+
+    // Score at the given quantile: the middle of its bucket, clamped to the
+    // scores actually seen so it never falls outside [min, max].
+    int64_t ScoreQuantile(const SimStats & st, int bucket, double q)
+    {
+        const int64_t i = Quantile(st.score_hist, st.games, q);
+        const int64_t lo = i * bucket;
+        const int64_t hi = (i + 1 == static_cast<int64_t>(kMaxScoreBuckets)) ? st.score_max : lo + bucket - 1;
+        return std::clamp(lo + (hi - lo) / 2, st.score_min, st.score_max);
+    }
+
+    void PrintStats(const SimOptions & opt, const SimStats & st, int threads, double seconds)
+    {
+        const double games = static_cast<double>(st.games);
+        const int b = opt.score_bucket;
+
+        std::printf("board          %dx%d\n", opt.width, opt.height);
+        std::printf("policy         %s\n", PolicyName(opt.policy));
+        std::printf("threads        %d\n", threads);
+        std::printf("games          %lld\n", static_cast<long long>(st.games));
+        std::printf("elapsed        %.3f s\n", seconds);
+        std::printf("games/sec      %.0f\n", games / std::max(seconds, 1e-9));
+        std::printf("moves/game     %.2f\n", static_cast<double>(st.moves) / games);
+
+        std::printf("score          mean %.2f  min %lld  p10 ~%lld  p50 ~%lld  p90 ~%lld  p99 ~%lld  max %lld\n",
+                    static_cast<double>(st.score_sum) / games,
+                    static_cast<long long>(st.score_min),
+                    static_cast<long long>(ScoreQuantile(st, b, 0.10)),
+                    static_cast<long long>(ScoreQuantile(st, b, 0.50)),
+                    static_cast<long long>(ScoreQuantile(st, b, 0.90)),
+                    static_cast<long long>(ScoreQuantile(st, b, 0.99)),
+                    static_cast<long long>(st.score_max));
+
+        if (st.deadlocks > 0)
+        {
+            std::printf("deadlocks      %lld (%.2f%%)  moves until deadlock: mean %.2f  p50 %lld  p90 %lld\n",
+                        static_cast<long long>(st.deadlocks),
+                        100.0 * static_cast<double>(st.deadlocks) / games,
+                        static_cast<double>(st.moves_to_deadlock_sum) / static_cast<double>(st.deadlocks),
+                        static_cast<long long>(Quantile(st.deadlock_hist, st.deadlocks, 0.50)),
+                        static_cast<long long>(Quantile(st.deadlock_hist, st.deadlocks, 0.90)));
+        }
+        else
+        {
+            std::printf("deadlocks      0 (every game reached --max-moves %d)\n", opt.max_moves);
+        }
+
+        if (st.cut_cascades > 0)
+        {
+            std::printf("cut cascades   %lld (stopped after %d steps)\n",
+                        static_cast<long long>(st.cut_cascades), kMaxCascadeSteps);
+        }
+
+        int64_t cascade_total = 0;
+        for (int64_t n : st.cascade_hist) cascade_total += n;
+        std::printf("cascade depth  (steps per move)\n");
+        for (size_t d = 1; d < st.cascade_hist.size(); ++d)
+        {
+            if (st.cascade_hist[d] == 0) continue;
+            std::printf("  %s%-3zu %14lld  %6.3f%%\n",
+                        d == kMaxCascadeBucket ? ">=" : "  ", d,
+                        static_cast<long long>(st.cascade_hist[d]),
+                        100.0 * static_cast<double>(st.cascade_hist[d]) / static_cast<double>(cascade_total));
+        }
+
+        std::printf("score histogram (bucket %d)\n", b);
+        if (st.score_hist.size() == kMaxScoreBuckets)
+        {
+            std::printf("  (the last bucket holds every score >= %lld)\n",
+                        static_cast<long long>((kMaxScoreBuckets - 1) * b));
+        }
+        const size_t rows = 20;
+        const size_t per_row = std::max<size_t>(1, (st.score_hist.size() + rows - 1) / rows);
+        for (size_t i = 0; i < st.score_hist.size(); i += per_row)
+        {
+            int64_t n = 0;
+            for (size_t j = i; j < std::min(st.score_hist.size(), i + per_row); ++j) n += st.score_hist[j];
+            std::printf("  [%7zu, %7zu) %14lld  %6.3f%%\n", i * b, (i + per_row) * b,
+                        static_cast<long long>(n), 100.0 * static_cast<double>(n) / games);
+        }
+    }
+}
+
+int main(int argc, char ** argv)
+{
+    SimOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        return 2;
+    }
+
+    const WorkStealingPool pool(opt.threads);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    SimStats stats;
+    if (opt.width == 6 && opt.height == 6)
+    {
+        stats = Simulate(opt, pool, Board());
+    }
+    else if (opt.width == 8 && opt.height == 8)
+    {
+        stats = Simulate(opt, pool, Board8());
+    }
+    else if (opt.width == 9 && opt.height == 9)
+    {
+        stats = Simulate(opt, pool, Board9());
+    }
+    else
+    {
+        stats = Simulate(opt, pool, DynamicBoard(opt.width, opt.height));
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    PrintStats(opt, stats, pool.ThreadCount(), seconds);
+    return 0;
+}
@@ -0,0 +1,393 @@
+// Replay verifier: re-simulates recorded sessions from their seed and swaps and
+// checks the recorded final score (and every keyframe) against the result.
+//
+//   match3_verify [--threads T] [--queue Q] [--quiet] <file|dir|-> ...
+//
+// Sessions are untrusted: boards wider or taller than --max-side and moves
+// that cascade for more than --max-steps steps fail verification instead of
+// being simulated to the end, so a crafted record cannot stall a worker.
+//
+// Inputs are replay files, which may hold any number of concatenated replays,
+// directories (scanned recursively) or '-' for stdin. They are streamed: one
+// reader thread pulls one replay at a time into a bounded queue that the
+// worker threads drain, so memory stays flat whatever the input size.
+//
+// Prints one line per session (only failures with --quiet) in completion
+// order, then totals and throughput. Exit status 0 if every session passed.
+
+#include "board.h"
+#include "replay.h"
+#include "bounded_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct VerifyOptions
+    {
+        int threads {0};
+        size_t queue {0};                       // 0: 64 per worker
+        bool quiet {false};
+        size_t max_record {size_t{64} << 20};   // larger records are treated as corrupt
+        int max_side {128};                     // larger boards fail as TooLarge
+        int max_steps {kMaxCascadeSteps};       // longer cascades fail as CascadeTooLong
+        std::vector<std::string> inputs;
+    };
+
+    struct Job
+    {
+        int source {0};        // index into the source name table
+        int64_t ordinal {0};   // position of the replay within its source
+        std::vector<uint8_t> bytes;
+    };
+
+    enum class Verdict
+    {
+        Pass,
+        Malformed,      // does not decode
+        BadSize,        // board size not playable
+        TooLarge,       // board beyond --max-side
+        Unplayable,     // seed gives no playable initial board
+        CascadeTooLong, // a move cascaded past --max-steps
+        ScoreMismatch,
+        KeyframeMismatch
+    };
+
+    const char * VerdictName(Verdict v)
+    {
+        switch (v)
+        {
+            case Verdict::Pass:             return "ok";
+            case Verdict::Malformed:        return "malformed";
+            case Verdict::BadSize:          return "bad board size";
+            case Verdict::TooLarge:         return "board too large";
+            case Verdict::Unplayable:       return "no playable initial board";
+            case Verdict::CascadeTooLong:   return "cascade too long";
+            case Verdict::ScoreMismatch:    return "score mismatch";
+            case Verdict::KeyframeMismatch: return "keyframe mismatch";
+        }
+        return "?";
+    }
+
+    struct Totals
+    {
+        std::atomic<int64_t> sessions {0};
+        std::atomic<int64_t> passed {0};
+        std::atomic<int64_t> failed {0};
+        std::atomic<int64_t> malformed {0};
+        std::atomic<int64_t> moves {0};
+    };
+
+    void PrintUsage()
+    {
+        std::fprintf(stderr,
+            "usage: match3_verify [--threads T] [--queue Q] [--quiet] [--max-record BYTES]\n"
+            "                     [--max-side N] [--max-steps N] <file|dir|-> ...\n");
+    }
+
+    bool ParseArgs(int argc, char ** argv, VerifyOptions & opt)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const char * arg = argv[i];
+            const char * val = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            auto need = [&]() { if (!val) { PrintUsage(); std::exit(2); } ++i; return val; };
+
+            if (!std::strcmp(arg, "--threads"))         opt.threads = std::atoi(need());
+            else if (!std::strcmp(arg, "--queue"))      opt.queue = static_cast<size_t>(std::atoll(need()));
+            else if (!std::strcmp(arg, "--max-record")) opt.max_record = static_cast<size_t>(std::atoll(need()));
+            else if (!std::strcmp(arg, "--max-side"))   opt.max_side = std::clamp(std::atoi(need()), 3, kMaxBoardSide);
+            else if (!std::strcmp(arg, "--max-steps"))  opt.max_steps = std::max(1, std::atoi(need()));
+            else if (!std::strcmp(arg, "--quiet"))      opt.quiet = true;
+            else if (arg[0] == '-' && arg[1] != '\0')
+            {
+                PrintUsage();
+                return false;
+            }
+            else
+            {
+                opt.inputs.push_back(arg);
+            }
+        }
+        if (opt.inputs.empty())
+        {
+            PrintUsage();
+            return false;
+        }
+        return true;
+    }
+
+    // Replays the session move by move, checking each keyframe on the way.
+    template <int W, int H>
+    Verdict Replay1(const Replay & rp, BasicBoard<W, H> & board, int max_steps, int64_t & score)
+    {
+        ReplayPlayer player(rp, max_steps);
+        // The size was checked before; only the seed can fail here.
+        if (!player.Reset(board))
+        {
+            return Verdict::Unplayable;
+        }
+
+        size_t next_key = 0;
+        for (;;)
+        {
+            const int position = player.Position();
+            if (next_key < rp.keyframes.size() && rp.keyframes[next_key].move_index == position)
+            {
+                const ReplayKeyframe & k = rp.keyframes[next_key++];
+                const bool same = k.score == player.Score() &&
+                                  std::equal(k.cells.begin(), k.cells.end(), board.CellData()) &&
+                                  std::equal(k.specials.begin(), k.specials.end(), board.SpecialData()) &&
+                                  k.rng_state == board.RngState();
+                if (!same)
+                {
+                    score = player.Score();
+                    return Verdict::KeyframeMismatch;
+                }
+            }
+            if (!player.Step(board))
+            {
+                break;
+            }
+            if (player.CascadeCut())
+            {
+                score = player.Score();
+                return Verdict::CascadeTooLong;
+            }
+        }
+
+        score = player.Score();
+        return score == rp.final_score ? Verdict::Pass : Verdict::ScoreMismatch;
+    }
+
+    // Per-worker boards, one per fixed size plus a dynamic one rebuilt on size changes.
+    struct WorkerBoards
+    {
+        Board b6;
+        Board8 b8;
+        Board9 b9;
+        std::optional<DynamicBoard> dynamic;
+
+        // The size comes from the record, so it is checked against the
+        // limits before any board of that size is built.
+        Verdict Run(const Replay & rp, const VerifyOptions & opt, int64_t & score)
+        {
+            const int w = rp.width;
+            const int h = rp.height;
+            if (w < 3 || h < 3 || w > kMaxBoardSide || h > kMaxBoardSide) return Verdict::BadSize;
+            if (w > opt.max_side || h > opt.max_side) return Verdict::TooLarge;
+            if (w == 6 && h == 6) return Replay1(rp, b6, opt.max_steps, score);
+            if (w == 8 && h == 8) return Replay1(rp, b8, opt.max_steps, score);
+            if (w == 9 && h == 9) return Replay1(rp, b9, opt.max_steps, score);
+            if (!dynamic || dynamic->Width() != w || dynamic->Height() != h)
+            {
+                dynamic.emplace(w, h);
+            }
+            return Replay1(rp, *dynamic, opt.max_steps, score);
+        }
+    };
+
+    class Verifier
+    {
+    public:
+        explicit Verifier(const VerifyOptions & opt) : opt_(opt) {}
+
+        void Worker()
+        {
+            WorkerBoards boards;
+            Replay rp;
+            Job job;
+            while (jobs_.Pop(job))
+            {
+                int64_t score = 0;
+                Verdict v = Verdict::Malformed;
+                if (DecodeReplay(job.bytes.data(), job.bytes.size(), rp))
+                {
+                    v = boards.Run(rp, opt_, score);
+                    totals_.moves.fetch_add(static_cast<int64_t>(rp.moves.size()), std::memory_order_relaxed);
+                }
+                Report(job.source, job.ordinal, v, score, rp);
+            }
+        }
+
+        // Queues every replay in every input; runs on the calling thread.
+        void ReadInputs()
+        {
+            for (const std::string & input : opt_.inputs)
+            {
+                if (input == "-")
+                {
+                    ReadStream(stdin, AddSource("<stdin>"));
+                    continue;
+                }
+
+                std::error_code ec;
+                if (std::filesystem::is_directory(input, ec))
+                {
+                    // Sorted so runs over the same directory list sessions the same way.
+                    std::vector<std::filesystem::path> files;
+                    for (auto it = std::filesystem::recursive_directory_iterator(input, ec);
+                         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+                    {
+                        if (it->is_regular_file(ec)) files.push_back(it->path());
+                    }
+                    std::sort(files.begin(), files.end());
+                    for (const auto & f : files) ReadFile(f.string());
+                }
+                else
+                {
+                    ReadFile(input);
+                }
+            }
+            jobs_.Close();
+        }
+
+        const Totals & Result() const { return totals_; }
+
+    private:
+        const VerifyOptions & opt_;
+        BoundedQueue<Job> jobs_ {opt_.queue};
+        Totals totals_;
+        std::mutex out_mutex_;
+        std::vector<std::string> sources_;   // written by the reader, read under out_mutex_
+
+        int AddSource(const std::string & name)
+        {
+            std::lock_guard<std::mutex> lock(out_mutex_);
+            sources_.push_back(name);
+            return static_cast<int>(sources_.size()) - 1;
+        }
+
+        void ReadFile(const std::string & path)
+        {
+            const int source = AddSource(path);
+            FILE * f = std::fopen(path.c_str(), "rb");
+            if (!f)
+            {
+                Report(source, 0, Verdict::Malformed, 0, Replay {});
+                return;
+            }
+            ReadStream(f, source);
+            std::fclose(f);
+        }
+
+        // Pulls one replay at a time. A broken header or a truncated record
+        // ends the source: there is no way to find the next record boundary.
+        void ReadStream(FILE * f, int source)
+        {
+            for (int64_t ordinal = 0;; ++ordinal)
+            {
+                uint8_t header[kReplayHeaderSize];
+                const size_t got = std::fread(header, 1, sizeof(header), f);
+                if (got == 0)
+                {
+                    return;
+                }
+
+                const size_t size = (got == sizeof(header)) ? ReplayRecordSize(header) : 0;
+                Job job;
+                job.source = source;
+                job.ordinal = ordinal;
+                if (size == 0 || size > opt_.max_record)
+                {
+                    Report(source, ordinal, Verdict::Malformed, 0, Replay {});
+                    return;
+                }
+
+                job.bytes.resize(size);
+                std::memcpy(job.bytes.data(), header, sizeof(header));
+                const size_t rest = size - sizeof(header);
+                if (std::fread(job.bytes.data() + sizeof(header), 1, rest, f) != rest)
+                {
+                    Report(source, ordinal, Verdict::Malformed, 0, Replay {});
+                    return;
+                }
+                jobs_.Push(std::move(job));
+            }
+        }
+
+        void Report(int source, int64_t ordinal, Verdict v, int64_t score, const Replay & rp)
+        {
+            totals_.sessions.fetch_add(1, std::memory_order_relaxed);
+            switch (v)
+            {
+                case Verdict::Pass:      totals_.passed.fetch_add(1, std::memory_order_relaxed); break;
+                case Verdict::Malformed: totals_.malformed.fetch_add(1, std::memory_order_relaxed); break;
+                default:                 totals_.failed.fetch_add(1, std::memory_order_relaxed); break;
+            }
+            if (opt_.quiet && v == Verdict::Pass)
+            {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(out_mutex_);
+            if (v == Verdict::Malformed)
+            {
+                std::printf("%-4s %s#%lld  %s\n", "FAIL", sources_[source].c_str(),
+                            static_cast<long long>(ordinal), VerdictName(v));
+                return;
+            }
+            std::printf("%-4s %s#%lld  %dx%d seed %u moves %zu score %lld recorded %lld  %s\n",
+                        v == Verdict::Pass ? "ok" : "FAIL", sources_[source].c_str(),
+                        static_cast<long long>(ordinal), rp.width, rp.height, rp.seed, rp.moves.size(),
+                        static_cast<long long>(score), static_cast<long long>(rp.final_score), VerdictName(v));
+        }
+    };
+}
+
+int main(int argc, char ** argv)
+{
+    VerifyOptions opt;
+    if (!ParseArgs(argc, argv, opt))
+    {
+        return 2;
+    }
+
+    const int threads = opt.threads > 0 ? opt.threads
+                                        : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (opt.queue == 0)
+    {
+        opt.queue = static_cast<size_t>(threads) * 64;
+    }
+
+    Verifier verifier(opt);
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int i = 0; i < threads; ++i)
+    {
+        workers.emplace_back([&] { verifier.Worker(); });
+    }
+    verifier.ReadInputs();
+    for (auto & t : workers)
+    {
+        t.join();
+    }
+
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const Totals & t = verifier.Result();
+    const int64_t sessions = t.sessions.load();
+    std::fflush(stdout);
+    std::fprintf(stderr,
+                 "threads %d  sessions %lld  passed %lld  failed %lld  malformed %lld\n"
+                 "elapsed %.3f s  sessions/sec %.0f  sessions/min %.0f  moves/sec %.0f\n",
+                 threads, static_cast<long long>(sessions), static_cast<long long>(t.passed.load()),
+                 static_cast<long long>(t.failed.load()), static_cast<long long>(t.malformed.load()),
+                 sec, sessions / std::max(sec, 1e-9), 60.0 * sessions / std::max(sec, 1e-9),
+                 static_cast<double>(t.moves.load()) / std::max(sec, 1e-9));
+
+    return (t.passed.load() == sessions) ? 0 : 1;
+}
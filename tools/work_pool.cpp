@@ -0,0 +1,125 @@
+#include "work_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct Range
+    {
+        int64_t begin {0};
+        int64_t end {0};
+    };
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+
+        void Push(const Range & r)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ranges.push_back(r);
+        }
+
+        // Owner takes the newest (smallest, cache-warm) range.
+        bool PopBack(Range & out)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ranges.empty()) return false;
+            out = ranges.back();
+            ranges.pop_back();
+            return true;
+        }
+
+        // Thieves take the oldest (largest) range.
+        bool PopFront(Range & out)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (ranges.empty()) return false;
+            out = ranges.front();
+            ranges.pop_front();
+            return true;
+        }
+    };
+}
+
+WorkStealingPool::WorkStealingPool(int threads)
+{
+    if (threads <= 0)
+    {
+        threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    threads_ = std::max(1, threads);
+}
+
+void WorkStealingPool::ParallelFor(int64_t count, int64_t grain, const RangeFn & fn) const
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    grain = std::max<int64_t>(1, grain);
+
+    const int n = static_cast<int>(std::min<int64_t>(threads_, (count + grain - 1) / grain));
+    if (n <= 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    queues.reserve(n);
+    for (int i = 0; i < n; ++i)
+    {
+        queues.push_back(std::make_unique<WorkerQueue>());
+        queues[i]->Push(Range{ count * i / n, count * (i + 1) / n });
+    }
+
+    std::atomic<int64_t> remaining { count };
+
+    auto worker = [&](int id) {
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            Range r;
+            bool got = queues[id]->PopBack(r);
+            for (int k = 1; !got && k < n; ++k)
+            {
+                got = queues[(id + k) % n]->PopFront(r);
+            }
+            if (!got)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Lazy binary splitting: expose the upper halves for stealing.
+            while (r.end - r.begin > grain)
+            {
+                const int64_t mid = r.begin + (r.end - r.begin) / 2;
+                queues[id]->Push(Range{ mid, r.end });
+                r.end = mid;
+            }
+
+            fn(r.begin, r.end, id);
+            remaining.fetch_sub(r.end - r.begin, std::memory_order_release);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n - 1);
+    for (int i = 1; i < n; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto & t : threads)
+    {
+        t.join();
+    }
+}
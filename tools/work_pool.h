@@ -0,0 +1,27 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+// Minimal work-stealing parallel-for for the headless tools.
+//
+// The index range is dealt out evenly across workers. A worker repeatedly
+// halves the range it holds, keeps the lower half and pushes the upper half
+// onto its own deque, until the piece is at most 'grain' long. Idle workers
+// steal the oldest (largest) range from another worker's deque, so uneven
+// per-item cost (long games, deep cascades) balances out.
+class WorkStealingPool
+{
+public:
+    // threads <= 0 uses std::thread::hardware_concurrency().
+    explicit WorkStealingPool(int threads = 0);
+
+    int ThreadCount() const { return threads_; }
+
+    // fn(begin, end, worker) is called on disjoint subranges covering [0, count).
+    // 'worker' is in [0, ThreadCount()) and can index per-thread state.
+    using RangeFn = std::function<void(int64_t begin, int64_t end, int worker)>;
+    void ParallelFor(int64_t count, int64_t grain, const RangeFn & fn) const;
+
+private:
+    int threads_ {1};
+};